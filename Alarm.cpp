@@ -2,6 +2,8 @@
 #include "Clock.h"
 #include "Config.h"
 #include "Pins.h"
+#include "RTC.h"
+#include "Buzzer.h"
 #include "BTN.h"
 #include "Alarm.h"
 
@@ -11,30 +13,48 @@ namespace Alarm
   
 BTN btnAlarm;
 bool alarmIsEnabled;  // alarm switch is on
-bool buzzerIsActive;  // buzzer is sounding
 bool alarmTriggered;  // have been triggered by alarm time, but only once
+uint8_t snoozes;      // since it went off
+int scheduledMinutes = -1;  // in the RTC's alarm, standard time
 
 void Init()
 {
   // Init the toggle/slider, and the state
-  pinMode(PIN_PWM_BUZZER, OUTPUT);
-  digitalWrite(PIN_PWM_BUZZER, LOW);
+  Buzzer::Init();
 #ifdef LCD_HAS_TOUCH
   alarmIsEnabled = Config::AlarmEnabled;
 #else
   btnAlarm.Init(PIN_SW_ALARM); // +ve means digital. Pin 13 has an LED and a resistor
   alarmIsEnabled = btnAlarm.IsDown();
 #endif  
-  buzzerIsActive = alarmTriggered = false;
+  alarmTriggered = false;
+#ifdef PIN_RTC_INT
+  pinMode(PIN_RTC_INT, INPUT_PULLUP);
+#endif
+  Schedule();
+#ifdef CONFIG_RTC_ALARM
+  rtc.CheckAlarm();  // discard a match from before the reset
+#endif
+}
+
+void Activate()
+{
+  // Sound the alarm, the buzzer's interrupt does the rest
+  snoozes = 0;
+  Buzzer::Start(Buzzer::AlarmPattern, CONFIG_ALARM_MINUTES*60U);
 }
 
 bool Loop()
 {
+#if defined(CONFIG_RTC_ALARM) && defined(PIN_RTC_INT)
+  if (!digitalRead(PIN_RTC_INT) && rtc.CheckAlarm() && alarmIsEnabled)
+    Activate();
+#endif
 #ifndef LCD_HAS_TOUCH
   // Check enabled state, returns true if changed
   bool enabled = !btnAlarm.IsDown(); // reverse the sense, just so alarm enabled lights the built-in LED
-  if (!enabled && buzzerIsActive)
-    Buzzer(false);  // make sure buzzer is off is alarm disabled
+  if (!enabled && Buzzer::IsActive())
+    Buzzer::Stop();  // make sure buzzer is off is alarm disabled
   if (enabled != alarmIsEnabled)
   {
     alarmIsEnabled = enabled;
@@ -44,12 +64,6 @@ bool Loop()
   return false;
 }
 
-void Buzzer(bool On)
-{
-  digitalWrite(PIN_PWM_BUZZER, On); // Buzzer is active type
-  buzzerIsActive = On;
-}
-
 bool IsEnabled()
 {
   return alarmIsEnabled;
@@ -61,24 +75,53 @@ void SetEnabled(bool enabled)
   Config::Save();
 }
 
+void Schedule()
+{
+#ifdef CONFIG_RTC_ALARM
+  // Program the RTC's alarm, it has standard time, the alarm is local
+  // With only the one alarm, the next to go off is just that one
+  int minutes = Config::AlarmHour24*60 + Config::AlarmMinute - Config::DLS*60;
+  if (minutes < 0)
+    minutes += 24*60;
+  if (minutes != scheduledMinutes && rtc.SetAlarm(minutes/60, minutes % 60))  // only if it's changed, Clock::Reset() calls this often
+    scheduledMinutes = minutes;
+#endif
+}
+
 void CheckActivation(byte Hour24, byte Minute)
 {
   // check if it's time to turn the buzzer on
+#ifdef CONFIG_RTC_ALARM
+#ifndef PIN_RTC_INT
+  // The RTC's flag, once a minute
+  if (rtc.CheckAlarm() && alarmIsEnabled)
+    Activate();
+#endif
+#else
   if (alarmIsEnabled && Hour24 == Config::AlarmHour24 && Minute == Config::AlarmMinute && !alarmTriggered)
   {
     alarmTriggered = true;
-    Buzzer(true);
+    Activate();
   }
   else
     alarmTriggered = false;
+#endif
 }
 
 bool CheckDeActivation()
 {
-  // Used with button press/touch, returns true if press absorbed and the buzzer killed
-  if (buzzerIsActive)
+  // Used with button press/touch, returns true if press absorbed and the buzzer snoozed or killed
+  if (Buzzer::IsActive())
   {
-    Buzzer(false);
+#ifdef CONFIG_ALARM_SNOOZE_MINUTES
+    if (!Buzzer::IsSnoozing() && snoozes < CONFIG_ALARM_SNOOZES)
+    {
+      snoozes++;
+      Buzzer::Snooze(CONFIG_ALARM_SNOOZE_MINUTES*60U);
+      return true;
+    }
+#endif
+    Buzzer::Stop();
     return true;
   }
   return false;
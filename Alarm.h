@@ -3,9 +3,9 @@ namespace Alarm
 {
     void Init();
     bool Loop();  // true if status changed
-    void Buzzer(bool On);
     bool IsEnabled();
     void SetEnabled(bool enabled);
+    void Schedule();  // after the alarm time or DLS changes
     void CheckActivation(byte Hour24, byte Minute);
     bool CheckDeActivation();
 };
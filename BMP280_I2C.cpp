@@ -0,0 +1,146 @@
+#include <Arduino.h>
+#include "RTC.h"
+#include "BMP280_I2C.h"
+
+// A simple implementation of BMP280 pressure/temperature reading, in forced mode
+// Uses FastI2C (softWire) because the LCD shield uses SDA & SCL, so BMP280_DEV (Wire) is out
+// Compensation is the 32-bit integer version from the Bosch datasheet
+
+namespace BMP280_I2C
+{
+enum RegisterIndices {CALIB = 0x88,
+                      STATUS = 0xF3, CTRL_MEAS, CONFIG,
+                      PRESS_MSB = 0xF7, TEMP_MSB = 0xFA};
+
+// ctrl_meas: osrs_t (x1), osrs_p (x8), mode (forced)
+//                       ttpppmm
+#define CTRL_MEAS_FORCED 0b00110001
+#define STATUS_MEASURING 0b00001000
+
+// Calibration ("trimming") values, read once
+uint16_t dig_T1;
+int16_t  dig_T2, dig_T3;
+uint16_t dig_P1;
+int16_t  dig_P2, dig_P3, dig_P4, dig_P5, dig_P6, dig_P7, dig_P8, dig_P9;
+
+void Write(uint8_t idx, uint8_t value)
+{
+  // Write the value at the given register/byte index
+  softWire.beginTransmission(BMP280_I2C_ADDR);
+  softWire.write(idx);
+  softWire.write(value);
+  softWire.endTransmission();  
+}
+
+uint16_t ReadCalib(uint8_t idx)
+{
+  // Read a 16-bit calibration value, LSB first
+  uint8_t bytes[2];
+  softWire.ReadRegisters(BMP280_I2C_ADDR, idx, bytes, 2);  // burst
+  return bytes[0] | (bytes[1] << 8);
+}
+
+// The status, then raw readings, PRESS_MSB..TEMP_XLSB, are read in the background
+uint8_t results[6];
+I2CTransaction resultsTransaction = {BMP280_I2C_ADDR, STATUS, results, 1, true, I2C_IDLE};
+
+int32_t ReadRaw(uint8_t idx)
+{
+  // Take a 20-bit raw reading, MSB, LSB, XLSB (top nibble), from the results
+  const uint8_t* bytes = results + (idx - PRESS_MSB);
+  int32_t val = bytes[0];
+  val = (val << 8) | bytes[1];
+  val = (val << 4) | (bytes[2] >> 4);
+  return val;
+}
+
+void Init()
+{
+  // Init the device
+  I2C_SITE(I2CSiteSensorInit);
+  dig_T1 = ReadCalib(CALIB +  0);
+  dig_T2 = ReadCalib(CALIB +  2);
+  dig_T3 = ReadCalib(CALIB +  4);
+  dig_P1 = ReadCalib(CALIB +  6);
+  dig_P2 = ReadCalib(CALIB +  8);
+  dig_P3 = ReadCalib(CALIB + 10);
+  dig_P4 = ReadCalib(CALIB + 12);
+  dig_P5 = ReadCalib(CALIB + 14);
+  dig_P6 = ReadCalib(CALIB + 16);
+  dig_P7 = ReadCalib(CALIB + 18);
+  dig_P8 = ReadCalib(CALIB + 20);
+  dig_P9 = ReadCalib(CALIB + 22);
+  Write(CONFIG, 0x00);  // no IIR filter
+}
+
+void StartConversion()
+{
+  // A single measurement, the device returns to sleep when done
+  I2C_SITE(I2CSiteSensorSample);
+  Write(CTRL_MEAS, CTRL_MEAS_FORCED);
+  resultsTransaction.reg = STATUS;
+  resultsTransaction.count = 1;
+  softWire.Queue(&resultsTransaction);
+}
+
+bool IsReady()
+{
+  // true once the forced conversion is complete and the results have been read
+  // Polls the status in the background until the conversion is done, then reads the results
+  I2C_SITE(I2CSiteSensorSample);
+  if (resultsTransaction.status == I2C_DONE)
+  {
+    if (resultsTransaction.reg == PRESS_MSB)
+      return true;
+    if (!(results[0] & STATUS_MEASURING))
+    {
+      resultsTransaction.reg = PRESS_MSB;
+      resultsTransaction.count = sizeof(results);
+    }
+    softWire.Queue(&resultsTransaction);
+  }
+  else if (resultsTransaction.status == I2C_FAILED)
+    softWire.Queue(&resultsTransaction);  // try again
+  return false;
+}
+
+int32_t FineTemperature()
+{
+  // "t_fine", used by both compensations
+  int32_t adc_T = ReadRaw(TEMP_MSB);
+  int32_t var1 = ((((adc_T >> 3) - ((int32_t)dig_T1 << 1))) * ((int32_t)dig_T2)) >> 11;
+  int32_t var2 = (((((adc_T >> 4) - ((int32_t)dig_T1)) * ((adc_T >> 4) - ((int32_t)dig_T1))) >> 12) * ((int32_t)dig_T3)) >> 14;
+  return var1 + var2;
+}
+
+int16_t GetTemperatureDeciC()
+{
+  // temperature in tenths of a degree Celcius
+  // t_fine is 5120ths of a degree (the datasheet's (t_fine*5 + 128) >> 8 is hundredths)
+  return (FineTemperature() + 256) >> 9;
+}
+
+int32_t GetPressurePa()
+{
+  // pressure in Pascals
+  int32_t t_fine = FineTemperature();
+  int32_t adc_P = ReadRaw(PRESS_MSB);
+  int32_t var1 = (t_fine >> 1) - 64000L;
+  int32_t var2 = (((var1 >> 2) * (var1 >> 2)) >> 11) * ((int32_t)dig_P6);
+  var2 = var2 + ((var1 * ((int32_t)dig_P5)) << 1);
+  var2 = (var2 >> 2) + (((int32_t)dig_P4) << 16);
+  var1 = (((dig_P3 * (((var1 >> 2) * (var1 >> 2)) >> 13)) >> 3) + ((((int32_t)dig_P2) * var1) >> 1)) >> 18;
+  var1 = ((((32768L + var1)) * ((int32_t)dig_P1)) >> 15);
+  if (var1 == 0)
+    return 0; // avoid division by zero
+  uint32_t p = (((uint32_t)(((int32_t)1048576L) - adc_P) - (var2 >> 12))) * 3125UL;
+  if (p < 0x80000000UL)
+    p = (p << 1) / ((uint32_t)var1);
+  else
+    p = (p / (uint32_t)var1) * 2;
+  var1 = (((int32_t)dig_P9) * ((int32_t)(((p >> 3) * (p >> 3)) >> 13))) >> 12;
+  var2 = (((int32_t)(p >> 2)) * ((int32_t)dig_P8)) >> 13;
+  return (int32_t)p + ((var1 + var2 + dig_P7) >> 4);
+}
+  
+};
@@ -0,0 +1,13 @@
+#pragma once
+
+#define BMP280_I2C_ADDR 0x76
+
+namespace BMP280_I2C  // BMP280 for Arduino, FastI2C
+{
+  // Does not init FastI2C.  Temperature 1x & Pressure 8x oversampling, forced mode
+  void Init();
+  void StartConversion();
+  bool IsReady();
+  int16_t GetTemperatureDeciC();  // 0.1C
+  int32_t GetPressurePa();
+};
@@ -13,14 +13,104 @@ BTN btn2Adj;
 
 #define READ(_pin) ((_pin > 0)?digitalRead(_pin):(analogRead(-_pin) > 512))
 
+// Analog buttons are read by the ADC, triggered by Timer0's overflow (the millis() timer, ~1kHz), one button per conversion
+// The interrupt debounces them, and posts their Events to a queue
+#define MAX_SCANNED     2
+#define SAMPLE_MS       (MAX_SCANNED*256UL*64UL*1000UL/F_CPU)  // 2ms
+#define DEBOUNCE_SAMPLES (HOLD_TIME_MS/SAMPLE_MS)
+#define LONG_HOLD_SAMPLES (2500/SAMPLE_MS)  // a Hold is 2.5s
+#define SCAN_ADMUX(_pin) ((1 << REFS0) | (1 << ADLAR) | (((_pin) >= A0)?(_pin) - A0:(_pin)))  // AVcc, 8 bits in ADCH
+#define SCAN_ADCSRA      ((1 << ADEN) | (1 << ADATE) | (1 << ADIE) | (1 << ADPS2) | (1 << ADPS1) | (1 << ADPS0))  // /128
+#define EVENT_QUEUE_SIZE 8  // a power of 2
+
+BTN* pScanned[MAX_SCANNED];
+uint8_t scanADMUX[MAX_SCANNED];
+uint8_t numScanned = 0;
+uint8_t scanIndex = 0;
+volatile uint8_t eventQueue[EVENT_QUEUE_SIZE];  // index << 4 | Event
+volatile uint8_t eventHead = 0, eventTail = 0;
+
 void BTN::Init(int Pin)
 {
   m_iPin = Pin;
   m_iPrevReading = OPEN_STATE;
   m_iPrevState = CLOSED_STATE;
   m_iTransitionTimeMS = millis();
+  m_iIndex = -1;
   if (m_iPin)
     pinMode(abs(m_iPin), INPUT_PULLUP);
+  if (m_iPin < 0 && numScanned < MAX_SCANNED)
+  {
+    m_bDown = false;
+    m_iSamples = m_iHeld = 0;
+    m_iIndex = numScanned;
+    ADCSRA = 0;
+    scanADMUX[numScanned] = SCAN_ADMUX(-m_iPin);
+    pScanned[numScanned++] = this;
+    scanIndex = 0;
+    ADMUX = scanADMUX[0];
+    ADCSRB = (1 << ADTS2);  // Timer0 overflow
+    ADCSRA = SCAN_ADCSRA | (1 << ADIF);
+  }
+}
+
+void BTN::Scan(bool Closed)
+{
+  // A new reading, post an Event if that's changed the state
+  uint8_t event = 0xFF;
+  if (Closed != m_bDown)
+  {
+    if (++m_iSamples >= DEBOUNCE_SAMPLES)
+    {
+      m_bDown = Closed;
+      m_iSamples = m_iHeld = 0;
+      event = Closed?Press:Release;
+    }
+  }
+  else
+  {
+    m_iSamples = 0;
+    if (m_bDown && m_iHeld < LONG_HOLD_SAMPLES && ++m_iHeld == LONG_HOLD_SAMPLES)
+      event = Hold;
+  }
+  if (event != 0xFF && ((eventTail + 1) & (EVENT_QUEUE_SIZE - 1)) != eventHead)  // (dropped if full)
+  {
+    eventQueue[eventTail] = (m_iIndex << 4) | event;
+    eventTail = (eventTail + 1) & (EVENT_QUEUE_SIZE - 1);
+  }
+}
+
+ISR(ADC_vect)
+{
+  // The conversion's complete, the next channel is converted on the next trigger
+  pScanned[scanIndex]->Scan(ADCH < 128);
+  if (++scanIndex == numScanned)
+    scanIndex = 0;
+  ADMUX = scanADMUX[scanIndex];
+}
+
+int8_t BTN::NextEvent()
+{
+  // Only if this button's Event is at the head of the queue, so pressing the other doesn't get lost
+  if (m_iIndex == -1 || eventHead == eventTail || (eventQueue[eventHead] >> 4) != m_iIndex)
+    return -1;
+  int8_t event = eventQueue[eventHead] & 0x0F;
+  eventHead = (eventHead + 1) & (EVENT_QUEUE_SIZE - 1);
+  return event;
+}
+
+int BTN::AnalogRead(int Pin)
+{
+  // Stop the triggering, let any conversion finish, then a plain analogRead()
+  uint8_t adcsra = ADCSRA;
+  uint8_t admux = ADMUX;
+  ADCSRA = adcsra & ~((1 << ADATE) | (1 << ADIE) | (1 << ADIF));
+  while (ADCSRA & (1 << ADSC))
+    ;
+  int value = analogRead(Pin);
+  ADMUX = admux;
+  ADCSRA = adcsra | (1 << ADIF);  // resume, clearing the flag so this isn't taken as a scan
+  return value;
 }
 
 bool BTN::CheckButtonPress()
@@ -28,6 +118,16 @@ bool BTN::CheckButtonPress()
   // debounced button, true if button pressed
   if (!m_iPin) return false;
 
+  if (m_iIndex != -1)
+  {
+    // discarding any Release & Hold before the Press
+    int8_t event;
+    while ((event = NextEvent()) != -1)
+      if (event == Press)
+        return true;
+    return false;
+  }
+
   int ThisReading = READ(m_iPin);
   if (ThisReading != m_iPrevReading)
   {
@@ -48,6 +148,8 @@ bool BTN::CheckButtonPress()
 bool BTN::IsDown()
 {
   if (!m_iPin) return false;
+  if (m_iIndex != -1)
+    return m_bDown;  // debounced, by the interrupt
   // non-debounced, instantaneous reading
   return READ(m_iPin) == CLOSED_STATE;
 }
@@ -3,15 +3,27 @@
 class BTN
 {
   public:
-    void Init(int Pin); // a -ve pin is Analog
+    enum Events {Press, Hold, Release};
+
+    void Init(int Pin); // a -ve pin is Analog, scanned in the background by the ADC interrupt
     bool CheckButtonPress();
+    int8_t NextEvent();  // Analog only, the oldest of this button's Events, or -1
     bool IsDown();
+
+    static int AnalogRead(int Pin);  // analogRead(), pausing the background scan
+
+    void Scan(bool Closed);  // from the ADC interrupt
     
   private:
     int m_iPin;
     int m_iPrevReading;
     int m_iPrevState;
     unsigned long m_iTransitionTimeMS;
+    // Analog, maintained by the ADC interrupt
+    int8_t m_iIndex;
+    volatile bool m_bDown;
+    uint8_t m_iSamples;  // that the reading has differed from m_bDown
+    uint16_t m_iHeld;    // samples m_bDown has been true
 };
 
 extern BTN btn1Set;
@@ -0,0 +1,188 @@
+#include <Arduino.h>
+#include "Pins.h"
+#include "Buzzer.h"
+
+namespace Buzzer
+{
+// A pattern is bursts of beeps, with a gap after each burst. After the bursts it moves on to the next pattern
+// Times are in ticks, 10ms
+struct Pattern
+{
+  uint8_t onTicks;    // each beep
+  uint8_t offTicks;   // between beeps
+  uint8_t beeps;      // per burst
+  uint8_t gapTicks;   // after each burst
+  uint8_t bursts;     // 0 is forever
+  int8_t next;        // the next pattern, -1 to stop
+};
+
+const Pattern pPatterns[] PROGMEM =
+{
+  // AlarmPattern, getting more insistent: ~30s of single beeps, ~30s of doubles, then quads
+  {10,  0, 1, 90, 30,  1},
+  {10, 10, 2, 70, 30,  2},
+  { 6,  6, 4, 40,  0, -1},
+};
+
+#define TIMER1_OCR1A (F_CPU/64/100 - 1)  // 100Hz, /64 prescaler
+
+volatile uint8_t* pBuzzerPort;
+uint8_t buzzerBit;
+
+// The interrupt's state
+volatile int8_t currentPattern = -1;  // or -1 when silent
+volatile uint16_t stopSeconds;        // counting down, 0 for never
+volatile uint16_t snoozeSeconds;      // counting down, silent while non-zero
+uint8_t startPattern;
+uint16_t startStopSeconds;
+Pattern pattern;
+uint8_t ticks;      // left in this on/off/gap
+uint8_t beep;       // in the burst, the beep is on while beep is odd
+uint8_t burst;
+uint8_t hundredths;
+bool on;
+
+void Init()
+{
+  // Timer1 CTC. The interrupt is only enabled while there's a pattern
+  pinMode(PIN_PWM_BUZZER, OUTPUT);
+  digitalWrite(PIN_PWM_BUZZER, LOW);
+  pBuzzerPort = portOutputRegister(digitalPinToPort(PIN_PWM_BUZZER));
+  buzzerBit = digitalPinToBitMask(PIN_PWM_BUZZER);
+  TCCR1A = 0;
+  TCCR1B = (1 << WGM12) | (1 << CS11) | (1 << CS10);
+  OCR1A = TIMER1_OCR1A;
+}
+
+void LoadPattern(uint8_t index)
+{
+  memcpy_P(&pattern, pPatterns + index, sizeof(pattern));
+  currentPattern = index;
+  beep = burst = 0;
+  on = true;
+  ticks = pattern.onTicks;
+}
+
+void Start(uint8_t index, uint16_t seconds)
+{
+  TIMSK1 &= ~(1 << OCIE1A);
+  startPattern = index;
+  startStopSeconds = stopSeconds = seconds;
+  snoozeSeconds = 0;
+  hundredths = 0;
+  LoadPattern(index);
+  TCNT1 = 0;
+  TIFR1 = (1 << OCF1A);
+  TIMSK1 |= (1 << OCIE1A);
+}
+
+void Snooze(uint16_t seconds)
+{
+  if (currentPattern == -1)
+    return;
+  TIMSK1 &= ~(1 << OCIE1A);
+  snoozeSeconds = seconds;
+  on = false;
+  *pBuzzerPort &= ~buzzerBit;
+  TIMSK1 |= (1 << OCIE1A);
+}
+
+void Stop()
+{
+  TIMSK1 &= ~(1 << OCIE1A);
+  currentPattern = -1;
+  snoozeSeconds = 0;
+  *pBuzzerPort &= ~buzzerBit;
+}
+
+bool IsActive()
+{
+  return currentPattern != -1;
+}
+
+bool IsSnoozing()
+{
+  return snoozeSeconds;
+}
+
+void Finish()
+{
+  // Stop, from the interrupt. It keeps running until the pin's off, see Tick()
+  currentPattern = -1;
+  snoozeSeconds = 0;
+  *pBuzzerPort &= ~buzzerBit;
+}
+
+void Tick()
+{
+  // One tick of the pattern
+  if (currentPattern == -1)
+  {
+    // Finished. An LCD write to PORTB may have raced with clearing the pin and put it back, clear it until it stays clear
+    if (*pBuzzerPort & buzzerBit)
+      *pBuzzerPort &= ~buzzerBit;
+    else
+      TIMSK1 &= ~(1 << OCIE1A);
+    return;
+  }
+  if (++hundredths == 100)
+  {
+    hundredths = 0;
+    if (snoozeSeconds)
+    {
+      if (!--snoozeSeconds)
+      {
+        // wake up, from the start
+        stopSeconds = startStopSeconds;
+        LoadPattern(startPattern);
+      }
+      return;
+    }
+    if (stopSeconds && !--stopSeconds)
+    {
+      Finish();
+      return;
+    }
+  }
+  if (snoozeSeconds)
+    return;
+  // The LCD writes PORTB too (preserving the buzzer's bit), so set the buzzer every tick, in case that raced with this
+  if (on)
+    *pBuzzerPort |= buzzerBit;
+  else
+    *pBuzzerPort &= ~buzzerBit;
+  if (--ticks)
+    return;
+  if (on)
+  {
+    // end of a beep, pause, or the gap after the burst
+    on = false;
+    ticks = (++beep < pattern.beeps)?pattern.offTicks:pattern.gapTicks;
+    if (!ticks)
+      ticks = 1;
+    return;
+  }
+  if (beep == pattern.beeps)
+  {
+    // end of the burst
+    beep = 0;
+    if (pattern.bursts && ++burst == pattern.bursts)
+    {
+      if (pattern.next == -1)
+      {
+        Finish();
+        return;
+      }
+      LoadPattern(pattern.next);
+      return;
+    }
+  }
+  on = true;
+  ticks = pattern.onTicks;
+}
+};
+
+ISR(TIMER1_COMPA_vect)
+{
+  Buzzer::Tick();
+}
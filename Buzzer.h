@@ -0,0 +1,15 @@
+#pragma once
+
+// Beeping patterns for the (active) buzzer, sequenced by Timer1's interrupt, 100 times a second
+// The main loop only starts, snoozes or stops them
+namespace Buzzer
+{
+  enum Patterns {AlarmPattern, Num_Patterns};
+
+  void Init();
+  void Start(uint8_t pattern, uint16_t stopSeconds);  // stops by itself after stopSeconds, or never if 0
+  void Snooze(uint16_t seconds);  // silent, then starts the pattern again
+  void Stop();
+  bool IsActive();  // sounding or snoozing
+  bool IsSnoozing();
+};
@@ -0,0 +1,81 @@
+#include <Arduino.h>
+#include "RTC.h"
+#include "Calendar.h"
+
+namespace Time {
+// Internally, years start on the 1st of March, so the leap day is the last day of the year,
+// and the months from March are 31,30,31,30,31, 31,30,31,30,31, 31,(28|29) days: 153 days every 5 months.
+// The days are counted from 1/3/1996, the start of a 4-year cycle, 1401 days before 1/1/2000
+#define DAYS_TO_2000 1401
+
+int DaysInMonth(int Month, int Year)  // 1..12
+{
+  // (Days-28) encoded as 2bits/Month 0b0000DD..FFJJ00
+  int Increment = (0x03BBEECCUL >> (2*Month) & 0x03);
+  if ((Year % 4) || Increment)    // (simple leap year test)
+    return 28 + Increment;
+  else
+    return 29;  // Leap year AND Feb
+}
+
+uint16_t DayNumber(int Date, int Month, int Year)
+{
+  // The day, since 1/1/2000
+  if (Month < 3)
+  {
+    Month += 9;  // March is 0
+    Year--;
+  }
+  else
+    Month -= 3;
+  Year -= 1996;
+  return 365U*Year + Year/4 + (153*Month + 2)/5 + Date - 1 - DAYS_TO_2000;
+}
+
+void FromDayNumber(uint16_t Day, int& Date, int& Month, int& Year)
+{
+  // The inverse of DayNumber()
+  unsigned long days = Day + DAYS_TO_2000;
+  Year = (4*days + 3)/1461;
+  int dayOfYear = days - (365UL*Year + Year/4);
+  Month = (5*dayOfYear + 2)/153;
+  Date = dayOfYear - (153*Month + 2)/5 + 1;
+  Year += 1996;
+  if (Month < 10)
+    Month += 3;
+  else
+  {
+    Month -= 9;
+    Year++;
+  }
+}
+
+uint8_t DayOfWeek(uint16_t Day)
+{
+  return (Day + 5) % 7 + 1;  // day 0 was a Saturday, 6
+}
+
+unsigned long MakeSeconds(int Date, int Month, int Year, int Hour, int Minute)
+{
+  // mktime-like thing, seconds since 1/1/2000 00:00
+  unsigned long Minutes = DayNumber(Date, Month, Year)*24UL*60UL;
+  Minutes += Hour*60UL + Minute;
+  return Minutes*60UL;
+}
+
+void SplitSeconds(unsigned long Seconds, int& Date, int& Month, int& Year, int& Hour, int& Minute)
+{
+  // The inverse of MakeSeconds()
+  unsigned long Minutes = Seconds/60UL;
+  uint16_t Day = Minutes/(24UL*60UL);
+  int minuteOfDay = Minutes - Day*24UL*60UL;
+  Hour = minuteOfDay/60;
+  Minute = minuteOfDay % 60;
+  FromDayNumber(Day, Date, Month, Year);
+}
+
+unsigned long RTCSeconds()
+{
+  return MakeSeconds(rtc.m_DayOfMonth, rtc.m_Month, rtc.m_Year + 2000, rtc.m_Hour24, rtc.m_Minute);
+}
+}
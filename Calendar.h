@@ -0,0 +1,15 @@
+#pragma once
+
+// Dates & times for 2000..2099 (so every 4th year is a leap year), closed form, no loops
+// Days are numbered from 1/1/2000 (day 0, a Saturday), seconds are since 1/1/2000 00:00
+// Years are 2000..2099
+namespace Time
+{
+  int DaysInMonth(int Month, int Year);  // 1..12
+  uint16_t DayNumber(int Date, int Month, int Year);
+  void FromDayNumber(uint16_t Day, int& Date, int& Month, int& Year);
+  uint8_t DayOfWeek(uint16_t Day);  // 1..7, Monday..Sunday, as the RTC
+  unsigned long MakeSeconds(int Date, int Month, int Year, int Hour, int Minute);
+  void SplitSeconds(unsigned long Seconds, int& Date, int& Month, int& Year, int& Hour, int& Minute);
+  unsigned long RTCSeconds();  // the RTC's time, to the minute. The full time must be read before calling
+};
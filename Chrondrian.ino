@@ -1,13 +1,12 @@
 #include <Arduino.h>
-// External libraries:
-#include <SoftwareI2C.h>  // see RTC.h & SPL06_I2C.h
-
+#include <avr/power.h>
 #include "Clock.h"
 #include "Alarm.h"
 #include "Config.h"
 #include "Pins.h"
 #include "BTN.h"
 #include "RTC.h"
+#include "Sched.h"
 
 // Chrondrian: an LCD clock with time, date, temperature, "weather", moon phase and alarm.
 // Inspired by something seen online, rectangles of subdued colour, visible "off" regions of 7-segment digits etc.
@@ -27,27 +26,28 @@
 // At runtime, press either the SET or the ADJ button.
 // SET:
 // Pressing SET enters config mode which sets the time, date etc. Initially the Time will blink.
-// Pressing SET will advance to setting the Alarm (if enabled), the Date and the Moon.
+// Pressing SET will advance to setting the Alarm (if enabled) and the Date.
 // Press ADJ to actually set the blinking item.
 // For the time, the hour will blink, ADJ increments it, SET moves on to the minutes.
 // Similarly for the alarm.
-// For the date, the order is year, month, date and day.
-// For the moon, the setting is the date and time of the next new moon.  This is done as two values:
-//   how many days to the new moon, this shows as "New in NNd", with NN blinking
-//   what time, on that day, the new moon occurs, this shows as "New at HHMM", with HH then MM blinking (24-hour)
+// For the date, the order is year, month and date. The day of the week follows from the date.
 //
-// *Holding* SET down toggles Daylight Savings off and on.
+// *Holding* SET down toggles Daylight Savings off and on (unless it is automatic, CONFIG_DLS_AUTO in Config.h).
 //
 // ADJ:
 // Pressing ADJ while the clock is running will toggle the Weather display between icons and text.
 // In config mode, ADJ increments the blinking field (and SET accepts the blinking value and advances to the next field)
 //
 // == Touch ==
-// Tapping the time, alarm, moon or date edits the corresponding value(s) (the alarm, only if enabled).
+// Tapping the time, alarm or date edits the corresponding value(s) (the alarm, only if enabled).
 // Tapping on the weather toggles between icons and text.
-// Touching and holding on the Time toggles DLS. On the Alarm, enables or disables it
+// Tapping on the temperature steps through today's and this week's temperature & pressure Low, High and Average, shown in the date cell,
+// eg TDL/ 6.40.  12 is today's low temperature, 12 degrees at 6:40. Pressures are at sea level, in hPa. Back to the date after 5s.
+// Touching and holding on the Time toggles DLS (unless it's automatic, see Config.h). On the Alarm, enables or disables it
 // When editing, tapping within the cell that has the blinking field increments it.  Tapping anywhere else advances to the next field (or finishes)
 //
+// While the alarm sounds, pressing a button or touching snoozes it, and pressing again while snoozing stops it. It stops by itself after 10 minutes
+//
 // There are a number of defines in Config.h which alter the clock at *compile* time, for example 12/24-hour mode, temperature units, etc.
 // Colours, layout/placement is defined at the top of Clock.cpp
 //
@@ -55,7 +55,8 @@
 // The "forecast" is computed using the Zambretti Forecaster algorithm. See Weather.cpp
 //
 // === Moon ===
-// The moon phase is computed from the reference new moon, using a period of ~29.53059 days.  So it WILL drift slowly. See Moon.cpp
+// The moon phase is interpolated between the new moons in a table, 2000 to 2099, good to a few minutes. See Moon.cpp & resources/encode_moons.py
+// The RTC's time zone is set in Config.h
 
 // === LCD ===
 // Switch between large and small LCDs using #define LCD_SMALL in Clock.h
@@ -72,6 +73,9 @@ void setup()
 #endif  
 #ifdef SERIALIZE
   Serial.begin(38400);
+#endif  
+#ifdef I2C_STATS
+  Serial.begin(38400);
 #endif  
   btn1Set.Init(-PIN_BTN_SET); // these are analog
   btn2Adj.Init(-PIN_BTN_ADJ);
@@ -79,21 +83,29 @@ void setup()
   LCD_INIT();
   LCD_FILL_BYTE(LCD_BEGIN_FILL(0, 0, LCD_WIDTH, LCD_HEIGHT), 0x00);
   rtc.setup();
+#ifdef CONFIG_IDLE_SLEEP
+  power_spi_disable();  // unused, save the power
+#endif
   Config::Load();
   Clock::Init();
 }
 
 void loop() 
 {
-  if (btn1Set.CheckButtonPress() && !Alarm::CheckDeActivation())
-    Config::Set();
-  else if (btn2Adj.CheckButtonPress() && !Alarm::CheckDeActivation())
-    Clock::Face();
-  else if (!Clock::CheckTouch())
+  // Nothing blocks, the clock keeps time while editing etc
+  Sched::Loop();
+  if (Config::Editing())
+    Config::Loop();
+  else if (!Clock::Splashing())
   {
-    Clock::Loop();
-    SERIALISE_ON(false);
+    if (btn1Set.CheckButtonPress() && !Alarm::CheckDeActivation())
+      Config::Set();
+    else if (btn2Adj.CheckButtonPress() && !Alarm::CheckDeActivation())
+      Clock::Face();
+    else
+      Clock::CheckTouch();
   }
-  else
-    Alarm::CheckDeActivation();
+  Clock::Loop();
+  SERIALISE_ON(false);
+  Sched::Idle();
 }
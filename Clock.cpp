@@ -5,8 +5,11 @@
 #include "Config.h"
 #include "Weather.h"
 #include "Moon.h"
+#include "Calendar.h"
+#include "DST.h"
 #include "Alarm.h"
 #include "Graphics.h"
+#include "Sched.h"
 
 namespace Clock 
 {
@@ -216,14 +219,13 @@ void PaintForecast(char forecast, bool icons)
     else if (forecast == '?')
     {
       pForecastStr = pNoneForecastStr; // "N/A"
-      float hPa = Weather::GetPressure();
-      if (hPa != 0.0)
+      int hPa = Weather::GetPressure();
+      if (hPa)
       {
         // show the current pressure!
         memset(buff, 0, sizeof(buff));
         char* pStr = buff;
-        int hPa = Weather::GetPressure() + 0.5;
-        Format(pStr, hPa + 0.5, 1000, ' ');
+        Format(pStr, hPa, 1000, ' ');
         Copy(pStr, " HPA");
         pForecastStr = buff;
         progmemStr = false; // read from buffer, not progmem
@@ -257,7 +259,6 @@ void PaintForecast(char forecast, bool icons)
   }
 }
 
-int MoonTextX = 0;
 void PaintWeather(char forecast, uint8_t segments)
 {
   // Paint the weather cell: forecast and moon phase
@@ -267,8 +268,7 @@ void PaintWeather(char forecast, uint8_t segments)
   Graphics::Text(CELL_X(pCellDef) + h, CELL_Y(pCellDef) + GAP_Y, Graphics::WeatherText, CONFIG_LCD_ON_COLOUR, pCellDef->_colour); 
 
   Graphics::TextSize(Graphics::MoonText, w, h);
-  MoonTextX = CELL_X(pCellDef) + CELL_W(pCellDef) - w - h;
-  Graphics::Text(MoonTextX, CELL_Y(pCellDef) + GAP_Y, Graphics::MoonText, CONFIG_LCD_ON_COLOUR, pCellDef->_colour); 
+  Graphics::Text(CELL_X(pCellDef) + CELL_W(pCellDef) - w - h, CELL_Y(pCellDef) + GAP_Y, Graphics::MoonText, CONFIG_LCD_ON_COLOUR, pCellDef->_colour); 
 
   PaintMoon(segments);
   
@@ -404,9 +404,6 @@ void ShowTime(char* str, size_t sizeofStr, int Hour24, int Minute, byte Mask)
   bool PM = false;
   memset(str, 0, sizeofStr);
   char* pStr = str;
-  Hour24 += Config::DLS;
-  if (Hour24 > 23)
-    Hour24 -= 24;
   FormatTime(Hour24, Minute, pStr, PM);
   PaintTime(str, PM, Mask);  
 }
@@ -445,6 +442,20 @@ void ShowDate(char* str, size_t sizeofStr, int day, int date, int month, int yea
   PaintDate(str, Mask);
 }
 
+void LocalTime(int& date, int& month, int& year, int& hour24, int& minute)
+{
+  // The displayed time, the RTC's (standard) time plus DLS. The full time must be read before calling
+  Time::SplitSeconds(Time::RTCSeconds() + Config::DLS*3600UL, date, month, year, hour24, minute);
+}
+
+void ShowToday(char* str, size_t sizeofStr)
+{
+  // format and paint the displayed date
+  int date, month, year, hour24, minute;
+  LocalTime(date, month, year, hour24, minute);
+  ShowDate(str, sizeofStr, Time::DayOfWeek(Time::DayNumber(date, month, year)), date, month, year - 2000, 0xFFFF);
+}
+
 void UpdateAlarm()
 {
   // format and update the alarm panel
@@ -474,7 +485,14 @@ int displayedMinute = -1;
 int displayedDay = -1;
 int displayedTemperature = -9999;
 char displayedForecast = ' ';
+int aggregateScreen = -1;  // the aggregate shown in the date cell, or -1 for the date
+unsigned long aggregateMS = 0;
+#define AGGREGATE_SHOW_MS 5000  // then back to the date
+int editingCell = Num_Cells;  // being edited by Config, so not painted here
+int holdCell = Num_Cells;     // touched, waiting to see if it's held
 uint8_t displayedSegments = 0xAA;
+unsigned long moonChangeSeconds = 0;  // when the moon's segments next change, local seconds since 1/1/2000
+unsigned long dlsChangeSeconds = 0;   // when DLS next starts or ends, ditto
 // Cleaner than ifdef's throughout
 #ifdef CONFIG_CELCIUS
 const bool displayCelcius = true;
@@ -482,33 +500,112 @@ const bool displayCelcius = true;
 const bool displayCelcius = false;
 #endif
 
+#define NUM_AGGREGATE_SCREENS 12
+void ShowAggregate(int screen)
+{
+  // Paint one of the weather aggregates in the date cell, as <T|P><D|W><L|H|A>/HH.MM.NNNN
+  // Temperature or Pressure, Day or Week, Low High or Average. The time is only shown for the day's Low & High (to 10 minutes)
+  bool week = screen >= NUM_AGGREGATE_SCREENS/2;
+  bool pressure = (screen % 6) >= 3;
+  int stat = screen % 3;
+  const Weather::Aggregate& aggregate = Weather::GetAggregate(week, pressure);
+  char str[16];
+  char* pStr = str;
+  memset(str, 0, sizeof(str));
+  *pStr++ = pressure?'P':'T';
+  *pStr++ = week?'W':'D';
+  *pStr++ = "LHA"[stat];
+  *pStr++ = '/';
+  uint16_t mask = 0b1110000000111100;
+  if (!aggregate.count)
+    Copy(pStr, "  .  .  --");
+  else
+  {
+    if (!week && stat != 2)
+    {
+      // always 24 hour, there's no room for PM. Already local time
+      int at = (stat == 0)?aggregate.minAt:aggregate.maxAt;
+      Format(pStr, at/6, 10, '0');
+      *pStr++ = '.';
+      Format(pStr, 10*(at % 6), 10, '0');
+      mask = 0b1110111110111100;
+    }
+    else
+      Copy(pStr, "  .  ");
+    *pStr++ = '.';
+    int value = (stat == 0)?aggregate.min:(stat == 1)?aggregate.max:aggregate.Mean();
+    value = (value + ((value < 0)?-5:+5))/10;  // to C or hPa
+    if (!pressure && !displayCelcius)
+      value = 9*value/5 + 32;
+    Format(pStr, value, 1000, ' ');
+  }
+  PaintDate(str, mask);
+}
+
+uint8_t MoonSegments()
+{
+  // The moon's segments, only calculated when they change. The full time must be read before calling
+  unsigned long nowSeconds = Time::RTCSeconds();
+  if (nowSeconds >= moonChangeSeconds)
+    return Moon::Segments(nowSeconds, moonChangeSeconds);
+  return displayedSegments;
+}
+
+void EndSplash()
+{
+  // Paint the clock face
+  PaintTime("  :  ", false, 0x00);  // compute position of the ':'
+  rtc.ReadTime(true);
+  displayedSegments = MoonSegments();
+  PaintWeather(Weather::GetForecast(), displayedSegments);
+  UpdateAlarm();
+  displayedMinute = -1;
+  displayedTemperature = -9999;  
+}
+
+bool Splashing()
+{
+  return Sched::IsRunning(Sched::SplashTimer);
+}
+
+bool CanPaint(int cell)
+{
+  // Not over the splash, a cell being edited, or the date while it's flashing DLS
+  if (Splashing() || cell == editingCell)
+    return false;
+  return cell != DateCell || !Sched::IsRunning(Sched::FlashTimer);
+}
+
+void SetEditing(int cell)
+{
+  editingCell = cell;
+}
+
 void Init()
 {
   // One-time initialisation
   PaintCellBackgrounds();
-#ifndef DEBUG  
-  Splash();
-  delay(5000);
-  PaintTime("  :  ", false, 0x00);  // compute position of the ':'
-#else
-  PaintTime("  :  ", false, 0x00);  // compute position of the ':'
-#endif
   Weather::Init();
   Alarm::Init();
-  PaintWeather(Weather::GetForecast(), Moon::Segments());
-  UpdateAlarm();
   updateMS = millis();
   colonOn = true;
-  displayedDay = displayedMinute = -1;
-  displayedTemperature = -9999;  
+  displayedDay = -1;
+#ifndef DEBUG  
+  Splash();
+  Sched::Start(Sched::SplashTimer, 5000, EndSplash);  // meanwhile, keep time
+  displayedMinute = -1;
+#else
+  EndSplash();
+#endif
 }
 
 void Loop()
 {
-  if (Alarm::Loop())
+  if (Alarm::Loop() && CanPaint(AlarmCell))
   {
     UpdateAlarm();
   }
+  Weather::Sample();
   // The main loop, update measurements, check button presses, update the display
   unsigned long nowMS = millis();
   if ((displayedMinute == -1) || (nowMS - updateMS) > 1000)
@@ -518,26 +615,54 @@ void Loop()
 #ifdef CONFIG_BLINK_COLON
     // Blinking colon
     colonOn = !colonOn;
-    UpdateColon(colonOn?CONFIG_LCD_ON_COLOUR:pCellDefs[TimeCell]._colourOff);
+    if (CanPaint(TimeCell))
+      UpdateColon(colonOn?CONFIG_LCD_ON_COLOUR:pCellDefs[TimeCell]._colourOff);
 #endif    
-    int minute = rtc.ReadMinute();
-    if (minute != displayedMinute)
+    rtc.StartReadMinute();  // in the background, picked up below
+    if (aggregateScreen != -1 && (nowMS - aggregateMS) > AGGREGATE_SHOW_MS)
+    {
+      aggregateScreen = -1;
+      char str[16];
+      if (CanPaint(DateCell))
+        ShowToday(str, sizeof(str));
+    }
+  }
+  byte minute;
+  if (rtc.EndReadMinute(minute))
+  {
+    if (minute != displayedMinute && rtc.ReadTime(true))  // else try again next time
     {
       displayedMinute = minute;
-      rtc.ReadTime(true);
-      Alarm::CheckActivation(rtc.m_Hour24, rtc.m_Minute);
+#ifdef CONFIG_DLS_AUTO
+      unsigned long nowSeconds = Time::RTCSeconds();
+      if (nowSeconds >= dlsChangeSeconds)
+      {
+        byte dls = DST::IsActive(nowSeconds, dlsChangeSeconds);
+        if (dls != Config::DLS)
+        {
+          Config::DLS = dls;
+          Alarm::Schedule();  // the RTC's alarm is in standard time
+        }
+      }
+#endif
       char str[16];
       char* pStr = str;
+      int date, month, year, hour24, minute;
+      LocalTime(date, month, year, hour24, minute);
+      Alarm::CheckActivation(hour24, minute);  // the alarm is local time
       // *** The time
-      ShowTime(str, sizeof(str), rtc.m_Hour24, rtc.m_Minute, 0xFF);
+      if (CanPaint(TimeCell))
+        ShowTime(str, sizeof(str), hour24, minute, 0xFF);
 
       // *** The date
-      ShowDate(str, sizeof(str), rtc.m_DayOfWeek, rtc.m_DayOfMonth, rtc.m_Month, rtc.m_Year, 0xFFFF);
+      if (aggregateScreen == -1 && CanPaint(DateCell))
+        ShowDate(str, sizeof(str), Time::DayOfWeek(Time::DayNumber(date, month, year)), date, month, year - 2000, 0xFFFF);
 
       Weather::Loop();
+      I2C_PRINT_STATS();
       // *** The temperature
       int T = Weather::GetTemperature();
-      if (T != displayedTemperature)
+      if (T != displayedTemperature && CanPaint(TemperatureCell))
       {
         displayedTemperature = T;
         memset(str, 0, sizeof(str));
@@ -548,13 +673,16 @@ void Loop()
         PaintTemperature(str, displayCelcius);
       }
       // *** The forecast+moon
-      char forecast = Weather::GetForecast();
-      uint8_t segments = Moon::Segments();
-      if (forecast != displayedForecast || segments != displayedSegments)
+      if (CanPaint(WeatherCell))
       {
-        displayedForecast = forecast;
-        displayedSegments = segments;
-        PaintWeather(forecast, segments);
+        char forecast = Weather::GetForecast();
+        uint8_t segments = MoonSegments();
+        if (forecast != displayedForecast || segments != displayedSegments)
+        {
+          displayedForecast = forecast;
+          displayedSegments = segments;
+          PaintWeather(forecast, segments);
+        }
       }
       
 #ifdef DEBUG  
@@ -567,8 +695,11 @@ void Loop()
 void Reset()
 {
   // Reset to refresh the display, eg after configuration
+  Alarm::Schedule();
   UpdateAlarm();
   displayedMinute = -1;
+  aggregateScreen = -1;
+  moonChangeSeconds = dlsChangeSeconds = 0;  // the time may have been changed
 }
 
 void Face()
@@ -608,58 +739,78 @@ bool GetTouch(int& x, int& y)
   return false;
 }
 
-void WaitForNoTouch()
+void TouchHeld()
 {
-  // waits until there is no touch detected
+  // The touch on holdCell was held -- toggle DLS, or the alarm
   int x, y;
-  while (LCD_GET_TOUCH(x, y))
-    ;
+  if (!LCD_GET_TOUCH(x, y))
+    return;  // just released, CheckTouch() treats it as a tap
+  if (holdCell == TimeCell)
+  {
+    Config::DLS = !Config::DLS;
+    Config::Save();
+    FlashDLS(Config::DLS);
+  }
+  else if (holdCell == AlarmCell)
+  {
+    Alarm::SetEnabled(!Alarm::IsEnabled());
+    UpdateAlarm();
+  }
+  holdCell = Num_Cells;
+  Reset();
 }
 
 bool CheckTouch()
 {
-  // Check for, and process touches
+  // Check for, and process touches. GetTouch() only reports a new touch, so there's no need to wait for it to be released
   int x, y;
+  if (holdCell != Num_Cells)
+  {
+    // waiting for TouchHeld()
+    if (LCD_GET_TOUCH(x, y))
+      return true;
+    // released before then, a tap
+    Sched::Stop(Sched::TouchHoldTimer);
+    int iCell = holdCell;
+    holdCell = Num_Cells;
+    Config::Edit(iCell);
+    return true;
+  }
   if (GetTouch(x, y) && !Alarm::CheckDeActivation())
   {
     int iCell = InCell(x, y);
+#ifdef CONFIG_DLS_AUTO
+    if (iCell == AlarmCell)
+#else
     if (iCell == TimeCell || iCell == AlarmCell)
+#endif
     {
-      // check for touch held -- toggle DLS
-      int delayCounter = 5;  // 5x half a second
-      bool touch = false;
-      while (delayCounter)
-      {
-        if (!(touch = LCD_GET_TOUCH(x, y)))
-          break;
-        delayCounter--;
-        delay(500);
-      }
-      if (!delayCounter && touch)
-      {
-        if (iCell == TimeCell)
-        {
-          Config::DLS = !Config::DLS;
-          Config::Save();
-          FlashDLS(Config::DLS);
-        }
-        else if (iCell == AlarmCell)
-        {
-          Alarm::SetEnabled(!Alarm::IsEnabled());
-          UpdateAlarm();
-        }
-        WaitForNoTouch();
-        Reset();
-        return true;
-      }
+      // check for touch held
+      holdCell = iCell;
+      Sched::Start(Sched::TouchHoldTimer, 2500, TouchHeld);
+      return true;
     }
-    if (iCell == WeatherCell && x < MoonTextX)
+    if (iCell == WeatherCell)
     {
       // touch on weather - toggle icon/test
       Face();
-      WaitForNoTouch();
       return true;   
     }
+    else if (iCell == TemperatureCell)
+    {
+      // touch on temperature - step through the aggregates, in the date cell
+      if (++aggregateScreen == NUM_AGGREGATE_SCREENS)
+        aggregateScreen = -1;
+      aggregateMS = millis();
+      if (aggregateScreen != -1)
+        ShowAggregate(aggregateScreen);
+      else
+      {
+        char str[16];
+        ShowToday(str, sizeof(str));
+      }
+      return true;
+    }
     else
     {
       Config::Edit(iCell);
@@ -681,13 +832,24 @@ int InCell(int x, int y)
 const char*    DLSOn    = "DLS/  .  .  0\xD4";    // 0xD4 = 'n'
 const char*    DLSOff   = "DLS/  .  . 0\xF1\xF1"; // 0xF1 = 'F'
 const uint16_t DLSmask = 0b1110000000111100;
+bool flashDLSOn = false;
+void FlashDLSEnd()
+{
+  Reset();  // repaints the date
+}
+
+void FlashDLSNew()
+{
+  PaintDate(flashDLSOn?DLSOn:DLSOff, DLSmask);
+  Sched::Start(Sched::FlashTimer, 1500, FlashDLSEnd);
+}
+
 void FlashDLS(bool On)
 {
-  // Flash the old, then new status of DLS
+  // Flash the old, then new status of DLS, the date isn't painted meanwhile
+  flashDLSOn = On;
   PaintDate(On?DLSOff:DLSOn, DLSmask);
-  delay(500);
-  PaintDate(On?DLSOn:DLSOff, DLSmask);
-  delay(1500);
+  Sched::Start(Sched::FlashTimer, 500, FlashDLSNew);
 }
 
 bool AlarmActive()
@@ -698,16 +860,17 @@ bool AlarmActive()
 
 void ShowDebug()
 {
-  // [DBG:PPPPP F  PPPPP:PPPPP T] current P, forecast letter, old, new MSL P, trend
+  // [DBG:PPPPP F  TTTT:PPPPP T CC] current P, forecast letter, 3 hour trend, MSL P, trend, confidence
   int16_t currentP;
   int16_t currentAdjP;
-  int16_t oldAdjP;
+  int16_t trendP;
+  uint8_t confidence;
   char trend;
   char buff[16];
   char* pStr;
   int x = CELL_X(pCellDefs + WeatherCell) + CELL_W(pCellDefs + WeatherCell)/3;
   const int y = CELL_Y(pCellDefs + WeatherCell) + 8;    
-  Weather::GetInfo(currentP, currentAdjP, oldAdjP, trend);      
+  Weather::GetInfo(currentP, currentAdjP, trendP, confidence, trend);      
   memset(buff, 0, sizeof(buff));
   pStr = buff;
   Copy(pStr, "DBG:");
@@ -718,11 +881,13 @@ void ShowDebug()
   
   memset(buff, 0, sizeof(buff));
   pStr = buff;
-  Format(pStr, oldAdjP, 10000, ' ');
+  Format(pStr, trendP, 1000, ' ');
   *pStr++ = ':';
   Format(pStr, currentAdjP, 10000, ' ');
   *pStr++ = ' ';
   *pStr++ = trend;
+  *pStr++ = ' ';
+  Format(pStr, confidence, 10, ' ');
   x = Graphics::PaintDebugStr(x, y, buff, 0, 0xFFFF);
 }
 
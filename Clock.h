@@ -50,6 +50,8 @@ namespace Clock
   void Reset();
   void Face();
   bool CheckTouch();
+  bool Splashing();
+  void SetEditing(int cell);  // Num_Cells for none, the cell isn't painted while it's edited
   int InCell(int x, int y);
 
   void FlashDLS(bool On);
@@ -64,5 +66,4 @@ namespace Clock
   void Copy(char*& pStr, const char* pValue);
   void Format(char*& pStr, int value, int MSD, char pad);
   bool GetTouch(int& x, int& y);
-  void WaitForNoTouch();
 };
@@ -1,10 +1,15 @@
 #include <Arduino.h>
 #include <EEPROM.h>
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
 #include "Config.h"
 #include "Clock.h"
-#include "Moon.h"
+#include "Calendar.h"
 #include "RTC.h"
 #include "BTN.h"
+#include "Alarm.h"
+#include "Sched.h"
 
 namespace Config
 {
@@ -14,43 +19,129 @@ byte AlarmHour24 = 7;
 byte AlarmMinute = 0;
 bool AlarmEnabled = false;  // only used on a touch screen, with no toggle switch
 bool ForecastIcons = true;
-unsigned long RefNewMoonSeconds = 750668100UL; // 15 October 2023, 6:55 a.m
 
-#define EEPROM_OFFSET 32 // don't overlap other projects
+// The settings are journalled, each Save() writes a record to the next of JOURNAL_SLOTS, so each byte wears 1/JOURNAL_SLOTS as fast.
+// Load() takes the valid record with the newest sequence. The record is written in the background, a byte per EEPROM-ready
+// interrupt, skipping bytes that are already right. The CRC is written last, so a half-written record is ignored
+#define EEPROM_OFFSET 32   // the original, unjournalled, settings, read once if there's no journal. Don't overlap other projects
+#define JOURNAL_OFFSET 64  // clear of the original settings
+#define JOURNAL_SLOTS 8
+#define JOURNAL_VERSION 1  // change when Record changes. Load() only reads this version's records, convert the previous version's there
+
+struct Record
+{
+  byte version;
+  byte sequence;
+  byte dls;
+  byte alarmHour24;
+  byte alarmMinute;
+  byte flags;  // ForecastIcons, AlarmEnabled
+  byte spare;
+  byte crc;
+};
+
+Record written = {0};  // the newest record in the EEPROM, or being written
+uint8_t journalSlot = JOURNAL_SLOTS - 1;  // of the written record
+volatile uint8_t writeIdx = sizeof(Record);  // the next byte to write
+volatile bool saveAgain = false;  // Save()d while writing
+
+byte CRC(const Record& record)
+{
+  byte crc = 0;
+  for (const byte* pByte = (const byte*)&record; pByte < &record.crc; pByte++)
+    crc = _crc8_ccitt_update(crc, *pByte);
+  return crc;
+}
+
 void Load()
 {
   // Read settings from EEPROM
+  bool found = false;
+  for (uint8_t slot = 0; slot < JOURNAL_SLOTS; slot++)
+  {
+    Record record;
+    EEPROM.get(JOURNAL_OFFSET + slot*sizeof(Record), record);
+    if (record.version == JOURNAL_VERSION && record.crc == CRC(record) &&
+        (!found || (int8_t)(record.sequence - written.sequence) > 0))
+    {
+      written = record;
+      journalSlot = slot;
+      found = true;
+    }
+  }
+  if (found)
+  {
+    DLS = written.dls?1:0;
+    AlarmHour24 = written.alarmHour24 % 24;
+    AlarmMinute = written.alarmMinute % 60;
+    ForecastIcons = written.flags & 0x01;
+    AlarmEnabled = written.flags & 0x02;
+    return;
+  }
   int idx = EEPROM_OFFSET;
   if (EEPROM.read(idx++) == 'C')
   {
+    // migrate
     DLS = EEPROM.read(idx++)?1:0;
     AlarmHour24 = EEPROM.read(idx++) % 24;
     AlarmMinute = EEPROM.read(idx++) % 60;
-    RefNewMoonSeconds = 0UL;
-    for (int b = 0; b < 4; b++) // Big endian
-    {
-      RefNewMoonSeconds <<= 8;
-      RefNewMoonSeconds |= EEPROM.read(idx++);
-    }
+    idx += 4;  // was the reference new moon
     ForecastIcons = EEPROM.read(idx++);
     AlarmEnabled = EEPROM.read(idx++);
   }
-  else
-    Save();
+  Save();
+}
+
+void StartRecord()
+{
+  // Start writing a record of the settings, if they've changed. Interrupts are off
+  Record record = written;
+  record.version = JOURNAL_VERSION;
+  record.dls = DLS?1:0;
+  record.alarmHour24 = AlarmHour24;
+  record.alarmMinute = AlarmMinute;
+  record.flags = (ForecastIcons?0x01:0) | (AlarmEnabled?0x02:0);
+  record.spare = 0;
+  if (!memcmp(&record, &written, sizeof(Record)) && written.crc == CRC(written))
+    return;  // unchanged
+  record.sequence++;
+  record.crc = CRC(record);
+  written = record;
+  journalSlot = (journalSlot + 1) % JOURNAL_SLOTS;
+  writeIdx = 0;
+  EECR |= _BV(EERIE);  // interrupts as soon as the EEPROM's ready
+}
+
+void ReadEEPROM(int idx, void* pData, uint8_t size)
+{
+  // For other modules' EEPROM data, the journal's interrupt mustn't change EEAR in the middle of a read
+  // The waiting is done with interrupts on, a byte being written takes ~3.3ms
+  for (;;)
+  {
+    while (writeIdx < sizeof(Record) || !eeprom_is_ready())
+      ;
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+    {
+      if (writeIdx == sizeof(Record) && eeprom_is_ready())
+      {
+        eeprom_read_block(pData, (const void*)idx, size);
+        return;
+      }
+    }
+    // a record was started in between
+  }
 }
 
 void Save()
 {
-  // Write settings to EEPROM
-  int idx = EEPROM_OFFSET;
-  EEPROM.write(idx++, 'C');
-  EEPROM.write(idx++, DLS?1:0);
-  EEPROM.write(idx++, AlarmHour24);
-  EEPROM.write(idx++, AlarmMinute);
-  for (int b = 0; b < 4; b++)
-    EEPROM.write(idx++, RefNewMoonSeconds >> 8*(3-b));
-  EEPROM.write(idx++, ForecastIcons?1:0);
-  EEPROM.write(idx++, AlarmEnabled?1:0);
+  // Write settings to EEPROM, in the background
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    if (writeIdx < sizeof(Record))
+      saveAgain = true;  // when that's done
+    else
+      StartRecord();
+  }
 }
 
 // B a s e
@@ -60,42 +151,37 @@ class Editor
   // Pressing Set goes to the next setting
   // Pressing Adj starts editing the setting (the first field within the setting (Hour, Year etc)
   // In that mode, Adj increments, Set goes to the next field
+  // Stepped from loop(), so the clock keeps going while editing
   public:
-    Editor(int cellIdx)
-    {
-      blinkTimerMS = idleTimerMS = millis();
-      cell = cellIdx;
-    }
+    Editor(int cellIdx):cell(cellIdx) {}
     
-    void DirectEdit()
+    void Begin(bool direct)
     {
-      // start with the first field
-      OnNextField(field = 0, offMask);
-      Edit();
+      // Start editing, direct starts with the first field
+      offMask = 0;
+      onMask = 0xFFFF;
+      update = blink = true;
+      exit = save = false;
+      field = -1;
+      OnBegin();
+      if (direct)
+        OnNextField(field = 0, offMask);
+      pActive = this;
+      Clock::SetEditing(cell);
+      Sched::Start(Sched::BlinkTimer, 500, Blink);
+      Sched::Start(Sched::IdleTimer, 30000, Idle);
     }
     
-    bool Edit()
+    bool Step()
     {
-      // The main edit loop
-      while (!exit)
+      // One pass of the edit loop, returns false when done
+      if (!exit)
       {
         if (update)
         {
           OnUpdate(blink?onMask:offMask);
           update = false;
         }
-        unsigned long nowMS = millis();
-        if ((nowMS - blinkTimerMS) > 500UL)  // toggle blink
-        {
-          blinkTimerMS = nowMS;
-          update = true;
-          blink = !blink;
-        }
-        if ((nowMS - idleTimerMS) > 30000UL)  // idle
-        {
-          field = 0;
-          exit = true;
-        }
         bool Set, Adj;
         CheckButtons(Set, Adj);        
         if (Set) // next field
@@ -104,7 +190,7 @@ class Editor
             exit = true;  // next setting
           else
             save = exit = OnNextField(++field, offMask);
-          idleTimerMS = nowMS;
+          Sched::Start(Sched::IdleTimer, 30000, Idle);
         }
         else if (Adj)  // increment field
         {
@@ -113,13 +199,26 @@ class Editor
           else
             OnNextValue(field);
           blink = update = true;
-          idleTimerMS = nowMS;
-        }    
+          Sched::Start(Sched::IdleTimer, 30000, Idle);
+        }
+        if (!exit)
+          return true;
       }
+      Sched::Stop(Sched::BlinkTimer);
+      Sched::Stop(Sched::IdleTimer);
       OnExit(save);
+      return false;
+    }
+
+    bool Edited()
+    {
+      // After editing, false if Set skipped past this setting
       return field != -1;
     }
 
+  // Load the setting's values
+  virtual void OnBegin() = 0;
+
   // Repaint the fields, with the given mask (on/off)
   virtual void OnUpdate(word mask) = 0;
   
@@ -133,6 +232,20 @@ class Editor
   virtual void OnExit(bool save) = 0;
   
   protected:
+    static void Blink()
+    {
+      // toggle blink
+      pActive->blink = !pActive->blink;
+      pActive->update = true;
+      Sched::Start(Sched::BlinkTimer, 500, Blink);
+    }
+
+    static void Idle()
+    {
+      pActive->field = 0;
+      pActive->exit = true;
+    }
+
     void CheckButtons(bool& Set, bool& Adj)
     {
       int x, y;
@@ -145,12 +258,13 @@ class Editor
         Adj = false;
       else
         Adj = btn2Adj.CheckButtonPress();
+      if ((Set || Adj) && Alarm::CheckDeActivation())
+        Set = Adj = false;  // it was to stop the alarm
     }
     
     static char str[16];
+    static Editor* pActive;  // for the timers
 
-    unsigned long blinkTimerMS = 0;
-    unsigned long idleTimerMS = 0;
     word offMask  = 0;  // start blinking everything
     word onMask  = 0xFFFF;  // start blinking everything
     bool update = true;
@@ -162,16 +276,23 @@ class Editor
 };
 
 char Editor::str[16]; // shared buffer
+Editor* Editor::pActive = NULL;
 
 // T i m e
 class TimeEditor:public Editor
 {
   public:
-    TimeEditor():Editor(Clock::TimeCell) {hour24 = rtc.m_Hour24; minute = rtc.m_Minute; }
+    TimeEditor():Editor(Clock::TimeCell) {}
+
+    void OnBegin() override
+    {
+      hour24 = rtc.m_Hour24;
+      minute = rtc.m_Minute;
+    }
 
     void OnUpdate(word mask) override
     { 
-      Clock::ShowTime(str, sizeof(str), hour24, minute, mask);
+      Clock::ShowTime(str, sizeof(str), (hour24 + DLS) % 24, minute, mask);  // as displayed
     }
     
     bool OnNextField(char field, word& offMask) override
@@ -218,7 +339,13 @@ class TimeEditor:public Editor
 class AlarmEditor:public TimeEditor
 {
   public:
-    AlarmEditor() {hour24 = Config::AlarmHour24; minute = Config::AlarmMinute; cell = Clock::AlarmCell; }
+    AlarmEditor() {cell = Clock::AlarmCell; }
+
+    void OnBegin() override
+    {
+      hour24 = Config::AlarmHour24;
+      minute = Config::AlarmMinute;
+    }
 
     void OnUpdate(word mask) override
     { 
@@ -242,11 +369,26 @@ class AlarmEditor:public TimeEditor
 class DateEditor:public Editor
 {
   public:
-    DateEditor():Editor(Clock::DateCell) {day = rtc.m_DayOfWeek - 1; date = rtc.m_DayOfMonth - 1; month = rtc.m_Month - 1; year = rtc.m_Year - 23; }
+    DateEditor():Editor(Clock::DateCell) {}
+
+    void OnBegin() override
+    {
+      // The local date, as displayed, not the RTC's (standard time) date
+      int hour24, minute;
+      Time::SplitSeconds(Time::RTCSeconds() + DLS*3600UL, date, month, year, hour24, minute);
+      date--;
+      month--;
+      year -= 2023;
+    }
+
+    byte DayOfWeek()
+    {
+      return Time::DayOfWeek(Time::DayNumber(date + 1, month + 1, year + 2023));
+    }
 
     void OnUpdate(word mask) override
     { 
-      Clock::ShowDate(str, sizeof(str), day + 1, date + 1, month + 1, year + 23, mask);
+      Clock::ShowDate(str, sizeof(str), DayOfWeek(), date + 1, month + 1, year + 23, mask);
     }
     
     bool OnNextField(char field, word& offMask) override
@@ -272,8 +414,6 @@ class DateEditor:public Editor
         date  %= Time::DaysInMonth(month + 1, year + 2023);
       }
 #endif        
-      else if (field == 3)
-        offMask = 0b0001111111111111; // Day
       else
         return true;   // done
       return false;
@@ -287,203 +427,150 @@ class DateEditor:public Editor
         month++;
       else if (field == 2)
         date++;
-      else if (field == 3)
-        day++;
       year  %= 20;
       month %= 12;
       date  %= Time::DaysInMonth(month + 1, year + 2023);
-      day   %= 7;
     }
 
     void OnExit(bool save) override
     {
       if (save)
       {
+        // The edited date is local, at the local time of day, back to standard time for the RTC
         rtc.ReadTime(true);
-        rtc.m_DayOfWeek = day + 1;
-        rtc.m_DayOfMonth = date + 1; 
-        rtc.m_Month = month + 1; 
-        rtc.m_Year = year + 23;
+        unsigned long timeOfDay = (Time::RTCSeconds() + DLS*3600UL) % (24*3600UL);
+        int newDate, newMonth, newYear, hour24, minute;
+        Time::SplitSeconds(Time::MakeSeconds(date + 1, month + 1, year + 2023, 0, 0) + timeOfDay - DLS*3600UL, newDate, newMonth, newYear, hour24, minute);
+        rtc.m_DayOfWeek = Time::DayOfWeek(Time::DayNumber(newDate, newMonth, newYear));
+        rtc.m_DayOfMonth = newDate; 
+        rtc.m_Month = newMonth; 
+        rtc.m_Year = newYear - 2000;
         rtc.WriteTime();      
       }
       else
        OnUpdate(0xFFFF);
     }
   private:
-    int day, date, month, year;
+    int date, month, year;
 };
 
 
-// M o o n
-class MoonEditor:public Editor
-{
-  public:
-    MoonEditor():Editor(Clock::DateCell)
-    {
-      Moon::NextNewMoon(inDays, atHour24, atMinute);
-      //         www dd.mm.yyyy
-      onMask = 0b1111110110111111;
-      segments = Moon::Segments();
-    }
-
-    void FormatStr()
-    {
-      memset(str, 0, sizeof(str));
-      char* pStr = str;
-      if (field == 0)
-      {
-        Clock::Copy(pStr, "NEW/\x86\xD4.  ."); // NEW In   XXXd"
-        Clock::Format(pStr, inDays, 100, ' ');
-        Clock::Copy(pStr, "\xDE"); // 'd'
-      }
-      else
-      {
-        Clock::Copy(pStr, "NEW/\xF7\xF8.  ."); // NEW At   HHMM"
-        Clock::Format(pStr, atHour24, 10, '0');
-        Clock::Format(pStr, atMinute, 10, '0');
-      }
-    }
-    
-    void OnUpdate(word mask) override
-    {
-      if (field == -1)
-        Clock::PaintMoon(mask?segments:~segments);  // blink the moon phase
-      else
-        Clock::PaintDate(str, mask);
-    }
-    
-    bool OnNextField(char field, word& offMask) override
-    {
-      FormatStr();
-      if (field == 0)
-      {
-        //          NEW in.  .XXXd
-        offMask = 0b1111110110000111; // days
-        Clock::PaintMoon(segments); // restore the moon phase
-      }
-      else if (field == 1)
-        offMask = 0b1111110110001111; // hour
-      else if (field == 2)
-        offMask = 0b1111110110110011; // minute
-      else
-        return true;   // done
-      return false;
-    }
-    
-    void OnNextValue(char field) override
-    {
-      if (field == 0)
-        inDays++;
-      else if (field == 1)
-        atHour24++;
-      else if (field == 2)
-        atMinute++;
-      inDays  %= 29;
-      atHour24 %= 24;
-      atMinute %= 60;
-      FormatStr();
-    }
+TimeEditor timeEditor;
+AlarmEditor alarmEditor;
+DateEditor dateEditor;
 
-    void OnExit(bool save) override
-    {
-      if (save)
-      {
-        rtc.ReadTime(true);
-        Config::RefNewMoonSeconds = Time::MakeSeconds(rtc.m_DayOfMonth, rtc.m_Month, rtc.m_Year + 2000, inDays*24 + atHour24, atMinute);
-        Config::Save();
-      }
-      else
-      {
-        OnUpdate(segments);
-      }
-    }
-  private:
-    uint8_t segments;
-    int inDays, atHour24, atMinute;
-};
+Editor* pEditor = NULL;  // being edited, stepped from Loop()
+bool chain = false;      // from Set(), go through the time, (alarm), and date
+#ifndef CONFIG_DLS_AUTO
+bool waitForHold = false;  // SET was pressed, holding it toggles DLS
+#endif
 
-bool CheckDLSToggle()
+void Start(Editor* pNext, bool direct)
 {
-  // check for SET held -- toggle DLS, returns true if was toggled
-  int delayCounter = 5;  // 5x half a second
-  while (delayCounter)
-  {
-    if (!btn1Set.IsDown())
-    {
-      break;
-    }
-    delayCounter--;
-    delay(500);
-  }
-  if (!delayCounter && btn1Set.IsDown())
-  {
-    // held
-    DLS = !DLS;
-    Save();
-    Clock::FlashDLS(DLS);
-    Clock::Reset();
-    return true;
-  }
-  return false;
+  pEditor = pNext;
+  pEditor->Begin(direct);
 }
 
 void Set()
 {
-  // choose to set the time, (alarm), date, or moon reference
-  if (CheckDLSToggle())
-    return;
-  TimeEditor time;
-  if (!time.Edit())
-  {
-    AlarmEditor alarm;
-    if (!Clock::AlarmActive() || !alarm.Edit()) // only edit alarm time if active
-    {
-      DateEditor date;
-      if (!date.Edit())
-      {
-        MoonEditor moon;
-        moon.Edit();
-      }
-    }
-  }
-  Clock::Reset();
+  // choose to set the time, (alarm), or date
+  chain = true;
+#ifndef CONFIG_DLS_AUTO
+  waitForHold = true;  // unless it's held, see Loop()
+#else
+  Start(&timeEditor, false);
+#endif
 }
 
 void Edit(int cell)
 {
-  switch (cell)
+  chain = false;
+  if (cell == Clock::TimeCell)
+    Start(&timeEditor, true);
+  else if (cell == Clock::AlarmCell && Clock::AlarmActive())
+    Start(&alarmEditor, true);
+  else if (cell == Clock::DateCell)
+    Start(&dateEditor, true);
+}
+
+bool Editing()
+{
+  // true while Loop() has work to do
+#ifndef CONFIG_DLS_AUTO
+  if (waitForHold)
+    return true;
+#endif
+  return pEditor != NULL;
+}
+
+void Loop()
+{
+  // Step the editing started by Set() or Edit()
+#ifndef CONFIG_DLS_AUTO
+  if (waitForHold)
   {
-    case Clock::TimeCell:
+    // check for SET held -- toggle DLS
+    int8_t event = btn1Set.NextEvent();
+    if (event == BTN::Hold)
     {
-      TimeEditor time;
-      time.DirectEdit();
-      break;
+      waitForHold = false;
+      DLS = !DLS;
+      Save();
+      Clock::FlashDLS(DLS);
+      Clock::Reset();
     }
-    case Clock::AlarmCell:
+    else if (event == BTN::Release || (event == -1 && !btn1Set.IsDown()))
     {
-      if (Clock::AlarmActive())
-      {      
-        AlarmEditor alarm;
-        alarm.DirectEdit();
-        break;
-      }
-      return;
+      waitForHold = false;
+      Start(&timeEditor, false);
     }
-    case Clock::DateCell:
+    return;
+  }
+#endif
+  if (!pEditor || pEditor->Step())
+    return;
+  if (chain && !pEditor->Edited())
+  {
+    // on to the next setting, only edit alarm time if active
+    if (pEditor == &timeEditor && Clock::AlarmActive())
     {
-      DateEditor date;
-      date.DirectEdit();
-      break;
+      Start(&alarmEditor, false);
+      return;
     }
-    case Clock::WeatherCell:
+    if (pEditor != &dateEditor)
     {
-      MoonEditor moon;
-      moon.DirectEdit();
-      break;
+      Start(&dateEditor, false);
+      return;
     }
-    default:
-      return;   
   }
+  pEditor = NULL;
+  Clock::SetEditing(Clock::Num_Cells);
   Clock::Reset();
 }
 };
+
+ISR(EE_READY_vect)
+{
+  // Write the record's next byte that differs from the EEPROM's
+  using namespace Config;
+  const byte* pRecord = (const byte*)&written;
+  while (writeIdx < sizeof(Record))
+  {
+    EEAR = JOURNAL_OFFSET + journalSlot*sizeof(Record) + writeIdx;
+    EECR |= _BV(EERE);
+    byte value = pRecord[writeIdx++];
+    if (EEDR != value)
+    {
+      EEDR = value;
+      EECR |= _BV(EEMPE);
+      EECR |= _BV(EEPE);
+      return;
+    }
+  }
+  EECR &= ~_BV(EERIE);
+  if (saveAgain)
+  {
+    saveAgain = false;
+    StartRecord();
+  }
+}
@@ -22,10 +22,29 @@
 // Display pulses slightly when blinking colon on non-USB power
 //#define CONFIG_BLINK_COLON
 
+// If defined, loop() sleeps (idle) until the next interrupt, rather than spinning. Timer0 (millis) wakes it every ms,
+// as do the button scanning, I2C and buzzer interrupts, so it's as responsive. Less current, and less pulsing
+#define CONFIG_IDLE_SLEEP
+
 // Display for Southern hemisphere, vs Northern
 // Also used to determine the season for the weather forecast
 #define CONFIG_SOUTHERN_HEMISPHERE
 
+// The RTC's (standard, non-DLS) time zone, minutes ahead of UTC. Used for the moon phase
+#define CONFIG_UTC_OFFSET_MINUTES 720
+
+// Daylight saving. If defined, DLS is switched by the rules below, otherwise it's toggled by hand (hold SET, or touch & hold the time)
+// DLS starts & ends on the Nth (1..4, or 5 for the last) Sunday of a month, at an hour of *standard* time (the RTC's time)
+// NZ: last Sunday of September 2am, to the first Sunday of April 3am NZDT (2am standard)
+// Central Europe: last Sunday of March 2am, to the last Sunday of October 2am. US: 2nd Sunday of March 2am, to the 1st Sunday of November 1am
+#define CONFIG_DLS_AUTO
+#define CONFIG_DLS_START_MONTH 9
+#define CONFIG_DLS_START_WEEK  5
+#define CONFIG_DLS_START_HOUR  2
+#define CONFIG_DLS_END_MONTH   4
+#define CONFIG_DLS_END_WEEK    1
+#define CONFIG_DLS_END_HOUR    2
+
 // Weather "forecast" constants etc. FOR ENTERTAINMENT ONLY!
 // Height above MSL in meters. If defined, used to adjust the air pressure reading to sea level
 #define CONFIG_ALTITUDE_METERS    20
@@ -34,19 +53,40 @@
 // This may make no sense!
 //#define CONFIG_MIN_PRESSURE_HPA  992
 //#define CONFIG_MAX_PRESSURE_HPA 1025 
+// The RTC is a DS3231/DS3232, the alarm is programmed into its Alarm 1, rather than compared every minute. Comment out for a DS1307
+// See also PIN_RTC_INT in Pins.h
+#define CONFIG_RTC_ALARM
+
+// The alarm sounds for this long, unless stopped
+#define CONFIG_ALARM_MINUTES 10
+// If defined, pressing a button (or touching) while the alarm sounds snoozes it, CONFIG_ALARM_SNOOZES times, then stops it
+// Pressing while snoozing stops it
+#define CONFIG_ALARM_SNOOZE_MINUTES 9
+#define CONFIG_ALARM_SNOOZES 3
+
+// Keep the half-hourly pressure readings, and today's temperature & pressure min/max/mean, in the RTC's RAM, so they survive a reset
+// Both need RAM from 0x14, a DS1307 or DS3232. A DS3231 has no registers past 0x12, leave them commented out
+//#define CONFIG_SAVE_READINGS
+//#define CONFIG_SAVE_AGGREGATES
+
+// Keep 40+ hours of temperature & pressure samples in RAM, see History.h. Uses ~320 bytes, and nothing displays them yet
+//#define CONFIG_HISTORY
 
 namespace Config
 {
   void Load();
   void Save();
+  void ReadEEPROM(int idx, void* pData, uint8_t size);  // safe while Save() writes in the background
 
   extern byte AlarmHour24;
   extern byte AlarmMinute;
   extern bool AlarmEnabled;
   extern byte DLS; 
-  extern unsigned long RefNewMoonSeconds;
   extern bool ForecastIcons;
 
+  // Editing runs from loop(), Set() or Edit() start it, Loop() steps it while Editing()
   void Set();
   void Edit(int cell);
+  bool Editing();
+  void Loop();
 };
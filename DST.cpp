@@ -0,0 +1,74 @@
+#include <Arduino.h>
+#include "Config.h"
+#include "Calendar.h"
+#include "DST.h"
+
+#ifdef CONFIG_DLS_AUTO
+namespace DST {
+unsigned long Sunday(int Year, int Month, int Week, int Hour)
+{
+  // The time of the Week'th (1..4, or 5 for the last) Sunday of the Month, at Hour
+  uint16_t day;
+  if (Week == 5)
+  {
+    day = Time::DayNumber(Time::DaysInMonth(Month, Year), Month, Year);
+    day -= Time::DayOfWeek(day) % 7;  // back to Sunday
+  }
+  else
+  {
+    day = Time::DayNumber(1, Month, Year);
+    day += (7 - Time::DayOfWeek(day)) % 7 + 7*(Week - 1);  // on to the Sunday
+  }
+  return day*24UL*60UL*60UL + Hour*60UL*60UL;
+}
+
+unsigned long Start(int Year)
+{
+  return Sunday(Year, CONFIG_DLS_START_MONTH, CONFIG_DLS_START_WEEK, CONFIG_DLS_START_HOUR);
+}
+
+unsigned long End(int Year)
+{
+  return Sunday(Year, CONFIG_DLS_END_MONTH, CONFIG_DLS_END_WEEK, CONFIG_DLS_END_HOUR);
+}
+
+bool IsActive(unsigned long seconds, unsigned long& changeSeconds)
+{
+  // Find the transitions either side of seconds, from this year's and next year's
+  int date, month, year, hour, minute;
+  Time::SplitSeconds(seconds, date, month, year, hour, minute);
+#if CONFIG_DLS_START_MONTH > CONFIG_DLS_END_MONTH
+  // Southern hemisphere, DLS at the start and end of the year
+  unsigned long end = End(year);
+  if (seconds < end)
+  {
+    changeSeconds = end;
+    return true;
+  }
+  unsigned long start = Start(year);
+  if (seconds < start)
+  {
+    changeSeconds = start;
+    return false;
+  }
+  changeSeconds = (year < 2099)?End(year + 1):0xFFFFFFFFUL;
+  return true;
+#else
+  unsigned long start = Start(year);
+  if (seconds < start)
+  {
+    changeSeconds = start;
+    return false;
+  }
+  unsigned long end = End(year);
+  if (seconds < end)
+  {
+    changeSeconds = end;
+    return true;
+  }
+  changeSeconds = (year < 2099)?Start(year + 1):0xFFFFFFFFUL;
+  return false;
+#endif
+}
+}
+#endif
@@ -0,0 +1,8 @@
+#pragma once
+
+// Daylight saving (DLS) from the rules in Config.h, if CONFIG_DLS_AUTO
+namespace DST
+{
+  // Whether DLS applies at seconds (standard time, since 1/1/2000), and when that next changes
+  bool IsActive(unsigned long seconds, unsigned long& changeSeconds);
+};
@@ -0,0 +1,549 @@
+#include <Arduino.h>
+#include <util/delay.h>
+#include "Pins.h"
+#include "FastI2C.h"
+
+// A bit-banged I2C master for the RTC/sensor bus, replacing SoftwareI2C
+// The pins are compile-time constants and driven through the port registers, not digitalWrite/pinMode
+// The lines are open-drain: a line is pulled LOW by making it an OUTPUT (its PORTB bit is always 0), 
+// and released HIGH by making it an INPUT, the module's pull-ups do the rest.
+// So *nothing* else may set the PORTB bits for SDA/SCL HIGH (the ILI948x code preserves them)
+// SBI/CBI on DDRB are atomic, so the LCD code's read-modify-write of PORTB doesn't interfere.
+// Slaves may stretch the clock, SCL is waited on, with a time-out.
+// Transactions can also be queued and run in the background from the Timer2 compare interrupt, 
+// a third of a bit per interrupt, so the main loop can paint the LCD while the RTC or sensor is read.
+
+/////////// UNO/NANO
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+#define I2C_SDA_BIT B00010000  // D12 PB4
+#define I2C_SCL_BIT B00001000  // D11 PB3
+#endif
+
+/////////// MEGA UNTESTED
+#if defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+#define I2C_SDA_BIT B01000000  // D12 PB6
+#define I2C_SCL_BIT B00100000  // D11 PB5
+#endif
+
+#if PIN_RTC_SDA != 12 || PIN_RTC_SCL != 11
+#error "FastI2C: I2C_SDA_BIT/I2C_SCL_BIT don't match PIN_RTC_SDA/PIN_RTC_SCL"
+#endif
+
+#define I2C_DDR  DDRB
+#define I2C_PORT PORTB
+#define I2C_PIN  PINB
+
+#define SDA_LOW()   I2C_DDR |=  I2C_SDA_BIT
+#define SDA_HIGH()  I2C_DDR &= ~I2C_SDA_BIT
+#define SDA_READ()  (I2C_PIN & I2C_SDA_BIT)
+#define SCL_LOW()   I2C_DDR |=  I2C_SCL_BIT
+#define SCL_RELEASE() I2C_DDR &= ~I2C_SCL_BIT
+#define SCL_READ()  (I2C_PIN & I2C_SCL_BIT)
+
+// Minimum LOW & HIGH periods of SCL, uS. Setup/hold times are covered by these plus the code
+#ifdef I2C_FAST_MODE
+#define I2C_LOW_US  1.3
+#define I2C_HIGH_US 0.6
+#else
+#define I2C_LOW_US  4.7
+#define I2C_HIGH_US 4.0
+#endif
+#define I2C_STRETCH_LIMIT 1000  // ~ms, give up waiting for a stretched clock
+
+#define I2C_WRITE 0
+#define I2C_READ  1
+
+// The asynchronous engine's interrupt rate, 40kHz (16MHz, /8 prescaler, /50). 3 interrupts per bit, ~13kHz SCL
+#define I2C_ASYNC_OCR2A 49
+#define I2C_ASYNC_STRETCH_LIMIT 40  // interrupts, ~1ms, then the transaction fails
+
+// The queue of asynchronous transactions, [asyncHead] is the one in progress
+#define I2C_QUEUE_SIZE 4
+I2CTransaction* volatile asyncQueue[I2C_QUEUE_SIZE];
+volatile uint8_t asyncHead = 0;
+volatile uint8_t asyncCount = 0;
+
+// The state of the transaction in progress, only touched by the interrupt (and Queue() when idle)
+enum AsyncPhase {AsyncStart0, AsyncStart1, AsyncStart2, AsyncStart3, AsyncBitSet, AsyncBitRelease, AsyncBitSample, AsyncStop0, AsyncStop1, AsyncStop2};
+enum AsyncStep  {StepAddressW, StepRegister, StepRestart, StepAddressR, StepData};
+uint8_t asyncPhase;
+uint8_t asyncStep;
+uint8_t asyncByte;    // being shifted out/in
+uint8_t asyncBit;     // 0..7, 8 is the ACK
+uint8_t asyncIndex;   // into pData
+bool asyncReading;    // asyncByte is coming from the slave
+bool asyncFailed;     // NACKed, or SCL held low
+uint8_t asyncStretched;  // interrupts SCL has been held low for
+
+#ifdef I2C_STATS
+// Statistics, since the last PrintStats
+struct I2CStats
+{
+  uint16_t transactions;
+  uint16_t bytes;
+  uint16_t nacks;
+  uint32_t micros;
+};
+#define I2C_STATS_DEVICES 4
+uint8_t statsAddresses[I2C_STATS_DEVICES];  // 0 is unused
+I2CStats deviceStats[I2C_STATS_DEVICES];
+I2CStats siteStats[Num_I2CSites];
+const char* const siteNames[Num_I2CSites] = {"other", "RTC time", "RTC minute", "RTC registers", "sensor init", "sensor sample"};
+
+// The synchronous transaction in progress
+bool statsActive = false;
+uint8_t statsAddress;
+uint8_t statsBytes;
+bool statsNack;
+uint32_t statsStartUS;
+// The asynchronous transactions
+uint8_t asyncSites[I2C_QUEUE_SIZE];
+uint32_t asyncStartUS;
+
+static void Tally(I2CStats& stats, uint8_t bytes, bool nack, uint32_t us)
+{
+  stats.transactions++;
+  stats.bytes += bytes;
+  stats.nacks += nack;
+  stats.micros += us;
+}
+
+static void Tally(uint8_t address, uint8_t site, uint8_t bytes, bool nack, uint32_t us)
+{
+  // Add a transaction to the totals for its device and site
+  for (int idx = 0; idx < I2C_STATS_DEVICES; idx++)
+    if (statsAddresses[idx] == address || !statsAddresses[idx])
+    {
+      statsAddresses[idx] = address;
+      Tally(deviceStats[idx], bytes, nack, us);
+      break;
+    }
+  Tally(siteStats[site], bytes, nack, us);
+}
+
+static void PrintStats(const char* pName, I2CStats& stats)
+{
+  Serial.print(pName);
+  Serial.print(": n=");Serial.print(stats.transactions);
+  Serial.print(" bytes=");Serial.print(stats.bytes);
+  Serial.print(" NACKs=");Serial.print(stats.nacks);
+  Serial.print(" us=");Serial.println(stats.micros);
+}
+
+void FastI2C::PrintStats()
+{
+  // Dump the totals to serial and start again. The interrupt may add to them while they're printed, it's only diagnostics
+  for (int idx = 0; idx < I2C_STATS_DEVICES && statsAddresses[idx]; idx++)
+  {
+    Serial.print("I2C 0x");Serial.print(statsAddresses[idx], HEX);
+    ::PrintStats("", deviceStats[idx]);
+  }
+  for (int site = 0; site < Num_I2CSites; site++)
+    if (siteStats[site].transactions)
+    {
+      Serial.print("I2C @");
+      ::PrintStats(siteNames[site], siteStats[site]);
+    }
+  uint8_t oldSREG = SREG;
+  cli();
+  memset(statsAddresses, 0, sizeof(statsAddresses));
+  memset(deviceStats, 0, sizeof(deviceStats));
+  memset(siteStats, 0, sizeof(siteStats));
+  SREG = oldSREG;
+}
+
+#define STATS_START()         if (!statsActive) { statsActive = true; statsBytes = 0; statsNack = false; statsStartUS = micros(); }
+#define STATS_BYTE(_data)     { if (!statsBytes++) statsAddress = (_data) >> 1; }
+#define STATS_NACK()          statsNack = true;
+#define STATS_STOP()          { statsActive = false; Tally(statsAddress, m_iSite, statsBytes, statsNack, micros() - statsStartUS); }
+#define STATS_QUEUE(_idx)     asyncSites[_idx] = m_iSite;
+#define STATS_ASYNC_START()   asyncStartUS = micros();
+#define STATS_ASYNC_STOP(_p)  Tally((_p)->address, asyncSites[asyncHead], (_p)->count + ((_p)->read?3:2), asyncFailed, micros() - asyncStartUS);
+#else
+#define STATS_START()
+#define STATS_BYTE(_data)
+#define STATS_NACK()
+#define STATS_STOP()
+#define STATS_QUEUE(_idx)
+#define STATS_ASYNC_START()
+#define STATS_ASYNC_STOP(_p)
+#endif
+
+static inline bool SCL_HIGH()
+{
+  // Release SCL and wait for it to go high, a slave may hold it low (clock stretching)
+  SCL_RELEASE();
+  uint16_t limit = I2C_STRETCH_LIMIT;
+  while (!SCL_READ())
+  {
+    if (!--limit)
+      return false;
+    _delay_us(1);
+  }
+  _delay_us(I2C_HIGH_US);
+  return true;
+}
+
+void FastI2C::begin()
+{
+  // Both lines released, never driven high
+  I2C_PORT &= ~(I2C_SDA_BIT | I2C_SCL_BIT);
+  SDA_HIGH();
+  SCL_RELEASE();
+  m_iRemaining = m_iError = 0;
+  // Timer2 CTC, for the asynchronous engine. The interrupt is only enabled while there are transactions
+  TCCR2A = (1 << WGM21);
+  TCCR2B = (1 << CS21);
+  OCR2A = I2C_ASYNC_OCR2A;
+}
+
+bool FastI2C::Start()
+{
+  while (Busy())  // the bus is the interrupt's
+    ;
+  STATS_START();
+  // (Repeated) START: SDA falls while SCL high
+  SDA_HIGH();
+  _delay_us(I2C_LOW_US);
+  if (!SCL_HIGH())
+  {
+    STATS_NACK();
+    return false;  // stuck, a START now would be garbage
+  }
+  SDA_LOW();
+  _delay_us(I2C_HIGH_US);
+  SCL_LOW();
+  return true;
+}
+
+void FastI2C::Stop()
+{
+  // STOP: SDA rises while SCL high
+  SDA_LOW();
+  _delay_us(I2C_LOW_US);
+  SCL_HIGH();
+  SDA_HIGH();
+  _delay_us(I2C_LOW_US);  // bus free time
+  STATS_STOP();
+}
+
+bool FastI2C::WriteByte(uint8_t data)
+{
+  // Clock out the byte, MSB first, return true if the slave ACKs
+  STATS_BYTE(data);
+  for (uint8_t mask = 0x80; mask; mask >>= 1)
+  {
+    if (data & mask)
+      SDA_HIGH();
+    else
+      SDA_LOW();
+    _delay_us(I2C_LOW_US);
+    if (!SCL_HIGH())
+    {
+      // stretched too long, abort as a NACK
+      SDA_HIGH();
+      STATS_NACK();
+      return false;
+    }
+    SCL_LOW();
+  }
+  SDA_HIGH(); // slave drives ACK
+  _delay_us(I2C_LOW_US);
+  bool ack = SCL_HIGH() && !SDA_READ();
+  SCL_LOW();
+  if (!ack)
+    STATS_NACK();
+  return ack;
+}
+
+bool FastI2C::ReadByte(uint8_t& data, bool ack)
+{
+  // Clock in a byte, MSB first, then ACK (more to come) or NACK (last byte). false if a clock was stretched too long
+  STATS_BYTE(0);
+  data = 0;
+  SDA_HIGH();
+  for (uint8_t bit = 0; bit < 8; bit++)
+  {
+    _delay_us(I2C_LOW_US);
+    if (!SCL_HIGH())
+    {
+      STATS_NACK();
+      return false;
+    }
+    data = (data << 1) | (SDA_READ()?1:0);
+    SCL_LOW();
+  }
+  if (ack)
+    SDA_LOW();
+  _delay_us(I2C_LOW_US);
+  bool ok = SCL_HIGH();
+  SCL_LOW();
+  SDA_HIGH();
+  if (!ok)
+    STATS_NACK();
+  return ok;
+}
+
+uint8_t FastI2C::beginTransmission(uint8_t address)
+{
+  m_iError = (Start() && WriteByte((address << 1) | I2C_WRITE))?0:2;
+  return !m_iError;
+}
+
+uint8_t FastI2C::write(uint8_t data)
+{
+  if (m_iError)
+    return false;
+  if (!WriteByte(data))
+    m_iError = 3;
+  return !m_iError;
+}
+
+uint8_t FastI2C::endTransmission()
+{
+  Stop();
+  return m_iError;
+}
+
+uint8_t FastI2C::requestFrom(uint8_t address, uint8_t count)
+{
+  if (!count || !Start() || !WriteByte((address << 1) | I2C_READ))
+  {
+    Stop();
+    m_iRemaining = 0;
+    return 0;
+  }
+  m_iRemaining = count;
+  return count;
+}
+
+uint8_t FastI2C::read()
+{
+  // returns 0xFF if nothing was requested (what a released bus reads as)
+  if (!m_iRemaining)
+    return 0xFF;
+  uint8_t data;
+  if (!ReadByte(data, --m_iRemaining != 0))
+  {
+    m_iRemaining = 0;  // abandon the rest
+    data = 0xFF;
+  }
+  if (!m_iRemaining)
+    Stop();
+  return data;
+}
+
+bool FastI2C::ReadRegisters(uint8_t address, uint8_t reg, uint8_t* pData, uint8_t count)
+{
+  // Write the register index then read count bytes after a repeated START
+  if (!Start() || !WriteByte((address << 1) | I2C_WRITE) || !WriteByte(reg))
+  {
+    Stop();
+    return false;
+  }
+  if (!Start() || !WriteByte((address << 1) | I2C_READ))
+  {
+    Stop();
+    return false;
+  }
+  bool ok = true;
+  while (ok && count--)
+    ok = ReadByte(*pData++, count != 0);
+  Stop();
+  return ok;
+}
+
+bool FastI2C::WriteRegisters(uint8_t address, uint8_t reg, const uint8_t* pData, uint8_t count)
+{
+  // Write the register index then count bytes
+  bool ack = Start() && WriteByte((address << 1) | I2C_WRITE) && WriteByte(reg);
+  while (ack && count--)
+    ack = WriteByte(*pData++);
+  Stop();
+  return ack;
+}
+
+bool FastI2C::Busy()
+{
+  return asyncCount != 0;
+}
+
+bool FastI2C::Queue(I2CTransaction* pTransaction)
+{
+  bool queued = false;
+  uint8_t oldSREG = SREG;
+  cli();
+  if (asyncCount < I2C_QUEUE_SIZE && pTransaction->status != I2C_PENDING)
+  {
+    pTransaction->status = I2C_PENDING;
+    asyncQueue[(asyncHead + asyncCount) % I2C_QUEUE_SIZE] = pTransaction;
+    STATS_QUEUE((asyncHead + asyncCount) % I2C_QUEUE_SIZE);
+    if (!asyncCount++)
+    {
+      STATS_ASYNC_START();
+      // idle, kick it off
+      asyncPhase = AsyncStart0;
+      asyncStep = StepAddressW;
+      asyncFailed = false;
+      asyncStretched = 0;
+      TCNT2 = 0;
+      TIFR2 = (1 << OCF2A);
+      TIMSK2 |= (1 << OCIE2A);
+    }
+    queued = true;
+  }
+  SREG = oldSREG;
+  return queued;
+}
+
+static void AsyncAdvance(I2CTransaction* pTransaction)
+{
+  // The START or byte is complete, set up the next element of the transaction
+  asyncBit = 0;
+  asyncReading = false;
+  asyncPhase = AsyncBitSet;
+  switch (asyncStep)
+  {
+    case StepAddressW:
+      asyncByte = (pTransaction->address << 1) | I2C_WRITE;
+      asyncStep = StepRegister;
+      break;
+    case StepRegister:
+      asyncByte = pTransaction->reg;
+      asyncStep = pTransaction->read?StepRestart:StepData;
+      asyncIndex = 0;
+      break;
+    case StepRestart:
+      asyncPhase = AsyncStart0;
+      asyncStep = StepAddressR;
+      break;
+    case StepAddressR:
+      asyncByte = (pTransaction->address << 1) | I2C_READ;
+      asyncStep = StepData;
+      break;
+    case StepData:
+      if (asyncIndex < pTransaction->count)
+      {
+        asyncReading = pTransaction->read;
+        asyncByte = asyncReading?0:pTransaction->pData[asyncIndex];
+        asyncIndex++;
+      }
+      else
+        asyncPhase = AsyncStop0;
+      break;
+  }
+}
+
+static void AsyncNext(I2CTransaction* pTransaction)
+{
+  // The transaction is over, on to the next one queued
+  pTransaction->status = asyncFailed?I2C_FAILED:I2C_DONE;
+  STATS_ASYNC_STOP(pTransaction);
+  asyncHead = (asyncHead + 1) % I2C_QUEUE_SIZE;
+  if (--asyncCount)
+  {
+    STATS_ASYNC_START();
+    asyncPhase = AsyncStart0;
+    asyncStep = StepAddressW;
+    asyncFailed = false;
+  }
+  else
+    TIMSK2 &= ~(1 << OCIE2A);
+}
+
+static bool AsyncStretched(I2CTransaction* pTransaction)
+{
+  // SCL has been released, true while a slave holds it low. Past the limit the transaction fails, and the bus is released
+  if (SCL_READ())
+  {
+    asyncStretched = 0;
+    return false;
+  }
+  if (++asyncStretched >= I2C_ASYNC_STRETCH_LIMIT)
+  {
+    asyncStretched = 0;
+    SDA_HIGH();
+    asyncFailed = true;
+    AsyncNext(pTransaction);
+  }
+  return true;
+}
+
+ISR(TIMER2_COMPA_vect)
+{
+  // One step of the transaction at the head of the queue
+  I2CTransaction* pTransaction = asyncQueue[asyncHead];
+  switch (asyncPhase)
+  {
+    case AsyncStart0:
+      SDA_HIGH();
+      asyncPhase = AsyncStart1;
+      break;
+    case AsyncStart1:
+      SCL_RELEASE();
+      asyncPhase = AsyncStart2;
+      break;
+    case AsyncStart2:
+      if (AsyncStretched(pTransaction))
+        break;
+      SDA_LOW();
+      asyncPhase = AsyncStart3;
+      break;
+    case AsyncStart3:
+      SCL_LOW();
+      AsyncAdvance(pTransaction);
+      break;
+    case AsyncBitSet:
+      // SCL is low, present the bit (or release SDA for the slave)
+      if (asyncBit < 8)
+      {
+        if (asyncReading || (asyncByte & 0x80))
+          SDA_HIGH();
+        else
+          SDA_LOW();
+      }
+      else if (asyncReading && asyncIndex < pTransaction->count)
+        SDA_LOW();  // ACK, more to come
+      else
+        SDA_HIGH(); // slave's ACK, or our NACK of the last byte
+      asyncPhase = AsyncBitRelease;
+      break;
+    case AsyncBitRelease:
+      SCL_RELEASE();
+      asyncPhase = AsyncBitSample;
+      break;
+    case AsyncBitSample:
+      if (AsyncStretched(pTransaction))
+        break;
+      if (asyncBit < 8)
+        asyncByte = (asyncByte << 1) | ((asyncReading && SDA_READ())?1:0);
+      else if (!asyncReading && SDA_READ())
+        asyncFailed = true; // NACK
+      SCL_LOW();
+      if (++asyncBit <= 8)
+        asyncPhase = AsyncBitSet;
+      else if (asyncFailed)
+        asyncPhase = AsyncStop0;
+      else
+      {
+        if (asyncReading)
+          pTransaction->pData[asyncIndex - 1] = asyncByte;
+        AsyncAdvance(pTransaction);
+      }
+      break;
+    case AsyncStop0:
+      SDA_LOW();
+      asyncPhase = AsyncStop1;
+      break;
+    case AsyncStop1:
+      SCL_RELEASE();
+      asyncPhase = AsyncStop2;
+      break;
+    case AsyncStop2:
+      if (AsyncStretched(pTransaction))
+        break;
+      SDA_HIGH();
+      AsyncNext(pTransaction);
+      break;
+  }
+}
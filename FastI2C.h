@@ -0,0 +1,66 @@
+#pragma once
+
+// Fast-mode (400kHz) timing, vs Standard-mode (100kHz)
+#define I2C_FAST_MODE
+
+// optionally count transactions, bytes, NACKs and time, per device and per call site, dumped to serial every minute:
+//#define I2C_STATS
+#ifdef I2C_STATS
+// The call sites. Each public RTC/sensor function names its site, it applies to all transactions until the next I2C_SITE
+enum I2CSites {I2CSiteOther, I2CSiteRTCTime, I2CSiteRTCMinute, I2CSiteRTCRegisters, I2CSiteSensorInit, I2CSiteSensorSample, Num_I2CSites};
+#define I2C_SITE(_site) softWire.m_iSite = _site;
+#define I2C_PRINT_STATS() softWire.PrintStats();
+#else
+#define I2C_SITE(_site)
+#define I2C_PRINT_STATS()
+#endif
+
+// An asynchronous transaction, queued and then run bit-by-bit from the Timer2 interrupt
+// Reads: START, address+W, reg, repeated START, address+R, count bytes into pData, STOP
+// Writes: START, address+W, reg, count bytes from pData, STOP
+enum I2CStatus {I2C_IDLE, I2C_PENDING, I2C_DONE, I2C_FAILED};
+struct I2CTransaction
+{
+  uint8_t address;
+  uint8_t reg;
+  uint8_t* pData;
+  uint8_t count;
+  bool read;
+  volatile uint8_t status;  // I2CStatus, the interrupt sets I2C_DONE/I2C_FAILED
+};
+
+class FastI2C  // Bit-banged I2C master on PIN_RTC_SDA/PIN_RTC_SCL, direct port access
+{
+  public:
+    void begin();
+    
+    // Wire-like. Bytes are sent/received as they are written/read, nothing is buffered
+    uint8_t beginTransmission(uint8_t address);  // true if ACKed
+    uint8_t write(uint8_t data);                  // true if ACKed
+    uint8_t endTransmission();                    // 0 if all ACKed, else 2 (address NACK) or 3 (data NACK), like Wire
+    uint8_t requestFrom(uint8_t address, uint8_t count);  // count, or 0 if NACKed
+    uint8_t read();  // the last requested byte is NACKed and the bus stopped. 0xFF, and no more, if the slave held SCL low
+    
+    // Burst register access, starting at reg, auto-incrementing. true if ACKed
+    bool ReadRegisters(uint8_t address, uint8_t reg, uint8_t* pData, uint8_t count);
+    bool WriteRegisters(uint8_t address, uint8_t reg, const uint8_t* pData, uint8_t count);
+
+    // Asynchronous. The transaction must stay in scope until its status is no longer I2C_PENDING
+    // Returns false (and doesn't queue) if the queue is full, or the transaction is already queued. The synchronous calls wait until the queue is empty
+    bool Queue(I2CTransaction* pTransaction);
+    bool Busy();
+
+#ifdef I2C_STATS
+    void PrintStats();  // and reset
+    uint8_t m_iSite = I2CSiteOther;  // the current call site, see I2C_SITE. Queue() records it with the transaction
+#endif
+
+  private:
+    bool Start();  // false if SCL is held low
+    void Stop();
+    bool WriteByte(uint8_t data);
+    bool ReadByte(uint8_t& data, bool ack);  // false if SCL is held low
+    
+    uint8_t m_iRemaining;
+    uint8_t m_iError;
+};
@@ -0,0 +1,150 @@
+#include <Arduino.h>
+#include "Config.h"
+#include "History.h"
+
+#ifdef CONFIG_HISTORY
+
+namespace History
+{
+// The samples are held in a ring of blocks. Each block has base values, then one byte per value per sample,
+// the change from the previous sample (so 2 bytes/sample, not 4). The first sample's change is from the base.
+// A change is clamped to +/-12.7 (hPa or C, in 20 minutes!) and the next change is from the clamped value, so it catches up.
+// When the newest block is full, the oldest is re-used and re-based on the newest value.
+// A block is also started early, so it can be based on it, for the first temperature or pressure since Clear() (the base
+// would be missing). After that, a change is from the last value stored, however many samples are missing in between.
+// So each block has its own count of samples. 6 blocks of 24 samples is 318 bytes.
+#define MISSING_DELTA -128
+
+struct Block
+{
+  int16_t baseTemperature;
+  int16_t basePressure;
+  int8_t temperatureDeltas[HISTORY_BLOCK_SAMPLES];
+  int8_t pressureDeltas[HISTORY_BLOCK_SAMPLES];
+  uint8_t count;  // samples in the block
+};
+
+Block blocks[HISTORY_BLOCKS];
+uint8_t numBlocks = 0;     // in use
+uint8_t newestBlock = 0;
+uint16_t numSamples = 0;   // in all the blocks
+uint32_t newestInterval = 0;
+// The newest values, as stored, the changes are from these
+int16_t lastTemperature = kMissing;
+int16_t lastPressure = kMissing;
+
+void Clear()
+{
+  numBlocks = newestBlock = 0;
+  numSamples = 0;
+  lastTemperature = lastPressure = kMissing;
+}
+
+int8_t Delta(int16_t value, int16_t& last)
+{
+  // The change from last to value, clamped, updating last
+  if (value == kMissing)
+    return MISSING_DELTA;
+  int8_t delta = constrain(value - last, MISSING_DELTA + 1, 127);
+  last += delta;
+  return delta;
+}
+
+void AddSample(int16_t temperature, int16_t pressure)
+{
+  if (!numBlocks || blocks[newestBlock].count == HISTORY_BLOCK_SAMPLES ||
+      (temperature != kMissing && lastTemperature == kMissing) || (pressure != kMissing && lastPressure == kMissing))
+  {
+    // Start a new block
+    if (numBlocks)
+      newestBlock = (newestBlock + 1) % HISTORY_BLOCKS;
+    if (numBlocks < HISTORY_BLOCKS)
+      numBlocks++;
+    else
+      numSamples -= blocks[newestBlock].count;  // re-using the oldest
+    blocks[newestBlock].count = 0;
+    if (temperature != kMissing)
+      lastTemperature = temperature;
+    if (pressure != kMissing)
+      lastPressure = pressure;
+    blocks[newestBlock].baseTemperature = lastTemperature;
+    blocks[newestBlock].basePressure = lastPressure;
+  }
+  Block& block = blocks[newestBlock];
+  block.temperatureDeltas[block.count] = Delta(temperature, lastTemperature);
+  block.pressureDeltas[block.count] = Delta(pressure, lastPressure);
+  block.count++;
+  numSamples++;
+}
+
+void Add(uint32_t interval, int16_t temperature, int16_t pressure)
+{
+  if (numBlocks)
+  {
+    if (interval == newestInterval)
+      return;  // already have it
+    uint32_t gap = interval - newestInterval - 1;  // (huge if the clock went backwards)
+    if (gap >= (uint32_t)HISTORY_BLOCKS*HISTORY_BLOCK_SAMPLES)
+      Clear();
+    else
+      while (gap--)
+        AddSample(kMissing, kMissing);
+  }
+  AddSample(temperature, pressure);
+  newestInterval = interval;
+}
+
+uint16_t Count()
+{
+  // The number of samples
+  return numSamples;
+}
+
+uint32_t NewestInterval()
+{
+  return newestInterval;
+}
+
+Iterator::Iterator():
+  m_Block((newestBlock + HISTORY_BLOCKS + 1 - numBlocks) % HISTORY_BLOCKS),
+  m_Sample(0),
+  m_Remaining(Count())
+{
+}
+
+bool Iterator::Next(int16_t& temperature, int16_t& pressure)
+{
+  // Decode the next sample
+  if (!m_Remaining)
+    return false;
+  if (m_Sample == blocks[m_Block].count)
+  {
+    m_Block = (m_Block + 1) % HISTORY_BLOCKS;
+    m_Sample = 0;
+  }
+  const Block& block = blocks[m_Block];
+  if (!m_Sample)
+  {
+    m_Temperature = block.baseTemperature;
+    m_Pressure = block.basePressure;
+  }
+  int8_t delta = block.temperatureDeltas[m_Sample];
+  if (delta != MISSING_DELTA)
+    m_Temperature += delta;
+  temperature = (delta != MISSING_DELTA)?m_Temperature:kMissing;
+  delta = block.pressureDeltas[m_Sample];
+  if (delta != MISSING_DELTA)
+    m_Pressure += delta;
+  pressure = (delta != MISSING_DELTA)?m_Pressure:kMissing;
+  m_Sample++;
+  m_Remaining--;
+  return true;
+}
+
+uint32_t Iterator::Interval()
+{
+  return newestInterval - m_Remaining;
+}
+
+};
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+// Temperature & pressure history, one sample every HISTORY_INTERVAL_MINUTES
+// Held compactly in RAM, see History.cpp. Up to 48 hours worth, with the values below (usually more than 40)
+// Only kept if CONFIG_HISTORY is defined, see Config.h
+#define HISTORY_INTERVAL_MINUTES 20
+#define HISTORY_BLOCK_SAMPLES    24  // 8 hours
+#define HISTORY_BLOCKS            6
+
+namespace History
+{
+  const int16_t kMissing = -32768;  // no value for the sample
+
+  void Clear();
+  // Add the sample (0.1C, dPa, or kMissing) for the given interval, the time in minutes/HISTORY_INTERVAL_MINUTES
+  // Skipped intervals are missing samples. An interval earlier than the newest clears the history
+  void Add(uint32_t interval, int16_t temperature, int16_t pressure);
+  uint16_t Count();
+  uint32_t NewestInterval();
+
+  class Iterator  // from the oldest sample to the newest
+  {
+    public:
+      Iterator();
+      bool Next(int16_t& temperature, int16_t& pressure);  // false when there are no more
+      uint32_t Interval();  // of the sample returned by Next()
+
+    private:
+      uint8_t m_Block;
+      uint8_t m_Sample;
+      uint16_t m_Remaining;
+      int16_t m_Temperature;
+      int16_t m_Pressure;
+  };
+};
@@ -1,6 +1,7 @@
 #include "arduino.h"
 #include <avr/pgmspace.h>
 #include "ILI948x.h"
+#include "BTN.h"
 
 #ifdef LCD_PORTRAIT_BOT
 #define MADCTL0x36 B00001000
@@ -38,14 +39,13 @@ bool ILI948x::_serialise = false;
 #define LCD_OR_CTRL_PORT B00100000 // Keep A5 INPUT_PULLUP (?)
 /////////// UNO/NANO
 #if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
-#define LCD_OR_PORTB  B00011000 // Keep  11, 12, (SDA & SCL) HIGH
-#define LCD_AND_PORTB B00000100 // Preserve 10
+#define LCD_AND_PORTB B00011100 // Preserve 10, 11, 12 (Buzzer, SCL & SDA. The I2C lines are open-drain, their PORTB bits must stay LOW, see FastI2C.cpp)
 #define CTRL_PORT PORTC
 #define CTRL_PIN  PINC
-// Blasts into TX, RX on PORTD and Pins 10, 11, 12, 13 on PORTB, pins on PORTC, EXCEPT what is set high by LCD_OR_PORTB & LCD_OR_CTRL_PORT
+// Blasts into TX, RX on PORTD and Pin 13 on PORTB, pins on PORTC, EXCEPT what is preserved by LCD_AND_PORTB or set high by LCD_OR_CTRL_PORT
 // Stop press: preserve pin 10 (Buzzer)
-#define CMD(_cmd)   { PORTD =  (_cmd); PORTB = (PORTB & LCD_AND_PORTB) | (LCD_OR_PORTB |  (_cmd & ~LCD_AND_PORTB)); CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT;              PINC = LCD_WR_BIT; }
-#define DATA(_data) { PORTD = (_data); PORTB = (PORTB & LCD_AND_PORTB) | (LCD_OR_PORTB | (_data & ~LCD_AND_PORTB)); CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT | LCD_RS_BIT; PINC = LCD_WR_BIT; }
+#define CMD(_cmd)   { PORTD =  (_cmd); PORTB = (PORTB & LCD_AND_PORTB) | ((_cmd) & ~LCD_AND_PORTB); CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT;              PINC = LCD_WR_BIT; }
+#define DATA(_data) { PORTD = (_data); PORTB = (PORTB & LCD_AND_PORTB) | ((_data) & ~LCD_AND_PORTB); CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT | LCD_RS_BIT; PINC = LCD_WR_BIT; }
 #endif
 
 /////////// MEGA
@@ -157,7 +157,7 @@ void ILI948x::Cmd(byte cmd)
   DATA_PINS(cmd);
 #else  
   PORTD = cmd & B11111100; 
-  PORTB = (PORTB & LCD_AND_PORTB) | (LCD_OR_PORTB | (cmd & B00000011)); 
+  PORTB = (PORTB & LCD_AND_PORTB) | (cmd & B00000011); 
 #endif  
   CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT;
   CTRL_PORT |= LCD_WR_BIT;
@@ -169,7 +169,7 @@ void ILI948x::DataByte(byte data)
   DATA_PINS(data);
 #else  
   PORTD = data & B11111100; 
-  PORTB = (PORTB & LCD_AND_PORTB) | (LCD_OR_PORTB | (data & B00000011)); 
+  PORTB = (PORTB & LCD_AND_PORTB) | (data & B00000011); 
 #endif  
   CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT | LCD_RS_BIT;
   CTRL_PORT |= LCD_WR_BIT;
@@ -190,7 +190,7 @@ void ILI948x::ColourByte(byte colour, unsigned long count)
     DATA_PINS(colour);
 #else
     PORTD = colour;
-    PORTB = (PORTB & LCD_AND_PORTB) | (LCD_OR_PORTB | colour);
+    PORTB = (PORTB & LCD_AND_PORTB) | (colour & ~LCD_AND_PORTB);
 #endif  
     CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT | LCD_RS_BIT;
     while (count--)
@@ -220,7 +220,8 @@ void ILI948x::OneWhite()
 #ifdef MEGA
   DATA_PINS(0xFF);
 #else  
-  PORTD = PORTB = 0xFF;
+  PORTD = 0xFF;
+  PORTB |= ~LCD_AND_PORTB;
 #endif  
   CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT | LCD_RS_BIT;
   CTRL_PIN = LCD_WR_BIT;
@@ -236,7 +237,7 @@ void ILI948x::OneBlack()
   DATA_PINS(0x00);
 #else  
   PORTD = 0x00;
-  PORTB = LCD_OR_PORTB;
+  PORTB &= LCD_AND_PORTB;
 #endif  
   CTRL_PORT = LCD_OR_CTRL_PORT | LCD_RST_BIT | LCD_RD_BIT | LCD_RS_BIT;
   CTRL_PIN = LCD_WR_BIT;
@@ -327,6 +328,8 @@ void ILI948x::InvertColours(bool invert)
 #define PIN_TOUCH_DY 6  // LCD_D6
 #define PIN_TOUCH_AX A1 // LCD_WR
 #define PIN_TOUCH_AY A2 // LCD_RS
+// Calibration, the raw readings at the edges of the panel, fixed at compile time. To find them for a panel, print
+// RAW_TOUCH_X()/RAW_TOUCH_Y() while touching each edge (as LCD::touchCalib() does for the XC4630)
 #define TOUCH_CALIB_X_MIN 90
 #define TOUCH_CALIB_X_MAX 835
 #define TOUCH_CALIB_Y_MIN 130
@@ -335,6 +338,53 @@ void ILI948x::InvertColours(bool invert)
 // the good one
 //#define TOUCH_CALIB_Y_MIN 150 good one
 //#define TOUCH_CALIB_Y_MAX 825
+
+#define TOUCH_SAMPLES    5   // per axis, the median is used
+#define TOUCH_SAMPLE_MS 20   // the panel is only read this often, in between the last reading is returned
+
+// pixels per raw unit, 16.16
+const uint32_t kTouchXScale = ((LCD_WIDTH - 1UL) << 16)/(TOUCH_CALIB_X_MAX - TOUCH_CALIB_X_MIN);
+const uint32_t kTouchYScale = ((LCD_HEIGHT - 1UL) << 16)/(TOUCH_CALIB_Y_MAX - TOUCH_CALIB_Y_MIN);
+
+int ReadTouchADC(int ADCPin)
+{
+  // The median of TOUCH_SAMPLES readings, a spike (or the first reading after switching) is ignored
+  int samples[TOUCH_SAMPLES];
+  for (int s = 0; s < TOUCH_SAMPLES; s++)
+  {
+    int value = BTN::AnalogRead(ADCPin);  // the buttons share the ADC
+    int i = s;
+    for (; i > 0 && samples[i - 1] > value; i--)
+      samples[i] = samples[i - 1];
+    samples[i] = value;
+  }
+  return samples[TOUCH_SAMPLES/2];
+}
+
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__)
+// The touch pins are D6 & D7 (PORTD), and WR & RS (CTRL_PORT, PORTC). Set directly, not with pinMode/digitalWrite
+int GetRawTouch(byte LOBitD, byte PUBitD, byte HIBitC, byte ADCBitC, int ADCPin)
+{
+  // set the pins to LOW, INPUT_PULLUP, HIGH, INPUT respectively, read from ADC pin
+  CTRL_PORT |= LCD_CS_BIT; // deselect LCD
+  PORTD &= ~LOBitD;
+  DDRD &= ~PUBitD;
+  PORTD |= PUBitD;
+  CTRL_PORT |= HIBitC;
+  DDRC &= ~ADCBitC;
+  CTRL_PORT &= ~ADCBitC;
+  int x = ReadTouchADC(ADCPin);
+
+  // restore, all outputs, HIGH
+  DDRC |= ADCBitC;
+  DDRD |= PUBitD;
+  PORTD |= LOBitD | PUBitD;
+  CTRL_PORT = (CTRL_PORT | ADCBitC) & ~LCD_CS_BIT;
+  return x;
+}
+#define RAW_TOUCH_X() GetRawTouch(1 << PIN_TOUCH_DX, 1 << PIN_TOUCH_DY, LCD_WR_BIT, LCD_RS_BIT, PIN_TOUCH_AY)
+#define RAW_TOUCH_Y() GetRawTouch(1 << PIN_TOUCH_DY, 1 << PIN_TOUCH_DX, LCD_RS_BIT, LCD_WR_BIT, PIN_TOUCH_AX)
+#else
 int GetRawTouch(int LOPin, int HIPin, int PUPin, int ADCPin)
 {
   // set the pins to LOW, HIGH, INPUT_PULLUP respectively, read from ADC pin
@@ -344,7 +394,7 @@ int GetRawTouch(int LOPin, int HIPin, int PUPin, int ADCPin)
   pinMode(PUPin, INPUT_PULLUP);
   
   pinMode(ADCPin, INPUT);
-  int x = analogRead(ADCPin);
+  int x = ReadTouchADC(ADCPin);
 
   // restore
   pinMode(ADCPin, OUTPUT);
@@ -355,17 +405,20 @@ int GetRawTouch(int LOPin, int HIPin, int PUPin, int ADCPin)
   digitalWrite(LCD_CS_PIN, LOW);
   return x;
 }
+#define RAW_TOUCH_X() GetRawTouch(PIN_TOUCH_DX, PIN_TOUCH_AX, PIN_TOUCH_DY, PIN_TOUCH_AY)
+#define RAW_TOUCH_Y() GetRawTouch(PIN_TOUCH_DY, PIN_TOUCH_AY, PIN_TOUCH_DX, PIN_TOUCH_AX)
+#endif
 
-bool ILI948x::GetTouch(int& x, int& y)
+bool ReadTouch(int& x, int& y)
 {
-  x = GetRawTouch(PIN_TOUCH_DX, PIN_TOUCH_AX, PIN_TOUCH_DY, PIN_TOUCH_AY);
+  x = RAW_TOUCH_X();
   if (TOUCH_CALIB_X_MIN <= x && x <= TOUCH_CALIB_X_MAX)
   {
-    y = GetRawTouch(PIN_TOUCH_DY, PIN_TOUCH_AY, PIN_TOUCH_DX, PIN_TOUCH_AX);
+    y = RAW_TOUCH_Y();
     if (TOUCH_CALIB_Y_MIN <= y && y <= TOUCH_CALIB_Y_MAX)
     {
-      x = map(x, TOUCH_CALIB_X_MIN, TOUCH_CALIB_X_MAX, 0, LCD_WIDTH - 1);
-      y = map(y, TOUCH_CALIB_Y_MIN, TOUCH_CALIB_Y_MAX, 0, LCD_HEIGHT - 1);
+      x = ((x - TOUCH_CALIB_X_MIN)*kTouchXScale) >> 16;
+      y = ((y - TOUCH_CALIB_Y_MIN)*kTouchYScale) >> 16;
 // Only the two landscape orientations are supported ATM      
 #ifndef LCD_LANDSCAPE_LEFT      
       x = LCD_WIDTH - x - 1;
@@ -376,6 +429,23 @@ bool ILI948x::GetTouch(int& x, int& y)
   }
   return false;
 }
+
+bool ILI948x::GetTouch(int& x, int& y)
+{
+  // At most every TOUCH_SAMPLE_MS, so polling it from the loop is cheap
+  static unsigned long sampleMS = 0;
+  static bool touched = false;
+  static int touchX, touchY;
+  unsigned long nowMS = millis();
+  if ((nowMS - sampleMS) >= TOUCH_SAMPLE_MS)
+  {
+    sampleMS = nowMS;
+    touched = ReadTouch(touchX, touchY);
+  }
+  x = touchX;
+  y = touchY;
+  return touched;
+}
 #else
 bool ILI948x::GetTouch(int& , int& )
 {
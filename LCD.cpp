@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include "LCD.h"
+#include "BTN.h"
 
 // The XC4630d hairball, see below
 // touch calibration data => raw values correspond to orientation 1
@@ -824,7 +825,7 @@ int XC4630_touchrawx(){           //raw analog value
 //  analogRead(A3);                 // discard first result after pinMode change
   
 //  delayMicroseconds(30);
-  x=analogRead(A3);
+  x=BTN::AnalogRead(A3);          // the buttons share the ADC
   
   // restore
   pinMode(A3,OUTPUT);
@@ -845,7 +846,7 @@ int XC4630_touchrawy(){           //raw analog value
 //  analogRead(A2);                 //discard first result after pinMode change
   
 //  delayMicroseconds(30);
-  y=analogRead(A2);
+  y=BTN::AnalogRead(A2);
   pinMode(A2,OUTPUT);
   digitalWrite(A2,HIGH);          //restore output state from above
   pinMode(8,OUTPUT);
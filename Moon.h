@@ -1,14 +1,8 @@
 #pragma once
 
 
-namespace Time
-{
-  int DaysInMonth(int Month, int Year);  // 1..12, 2001..2099
-  unsigned long MakeSeconds(int Date, int Month, int Year, int Hour, int Minute);
-};
-
 namespace Moon
 {
-  uint8_t Segments();
-  void NextNewMoon(int& InDays, int& AtHour24, int& AtMinute);
+  // The segments lit for the moon phase at localSeconds (standard time, since 1/1/2000), and the time they next change
+  uint8_t Segments(unsigned long localSeconds, unsigned long& changeSeconds);
 };
@@ -0,0 +1,72 @@
+#pragma once
+// Generated by resources/encode_moons.py, don't edit
+// New moon n is at MOON_FIRST_SECONDS + n*MOON_MEAN_LUNATION_SECONDS + pMoonTable[n]*MOON_UNIT_SECONDS, UTC seconds since 1/1/2000
+#define MOON_FIRST_SECONDS -2067869L
+#define MOON_MEAN_LUNATION_SECONDS 2551443UL
+#define MOON_UNIT_SECONDS 480
+#define MOON_TABLE_SIZE 1239
+static const int8_t pMoonTable[MOON_TABLE_SIZE] PROGMEM =
+{
+  -23,29,75,101,103,82,47,5,-38,-74,-98,-103,-84,-43,9,58,90,100,90,63,
+  26,-16,-55,-83,-94,-84,-54,-13,29,64,84,86,70,41,5,-30,-56,-69,-68,-56,
+  -33,-3,29,54,66,62,46,23,0,-19,-34,-45,-49,-44,-29,-8,13,30,39,42,
+  39,31,18,2,-16,-31,-41,-45,-42,-32,-14,8,30,47,53,49,36,18,-5,-29,
+  -52,-67,-70,-55,-26,9,42,64,74,70,53,24,-13,-50,-79,-92,-85,-58,-19,25,
+  65,90,96,80,48,5,-38,-75,-97,-101,-83,-46,4,55,92,106,95,65,25,-18,
+  -58,-88,-102,-95,-64,-16,36,76,97,96,77,44,5,-36,-69,-89,-89,-68,-33,8,
+  46,73,84,77,55,23,-12,-42,-61,-67,-60,-44,-19,10,38,57,62,53,34,13,
+  -7,-23,-36,-44,-46,-39,-22,-2,17,31,39,41,37,28,14,-3,-21,-36,-45,-48,
+  -42,-28,-7,17,39,53,56,48,31,9,-16,-42,-63,-74,-68,-45,-10,27,56,74,
+  77,66,41,6,-33,-68,-91,-94,-76,-40,4,48,82,98,92,66,27,-18,-59,-89,
+  -102,-95,-67,-21,32,77,103,103,81,45,3,-39,-74,-97,-100,-81,-40,11,58,88,
+  97,86,60,24,-16,-53,-79,-89,-78,-50,-12,27,59,77,80,66,39,5,-26,-50,
+  -61,-62,-51,-32,-7,21,45,57,56,43,25,5,-12,-26,-37,-44,-44,-34,-16,3,
+  21,33,40,41,36,26,10,-9,-27,-42,-50,-50,-41,-23,2,28,49,59,57,44,
+  24,-2,-30,-56,-74,-77,-62,-31,8,44,69,80,76,57,25,-14,-53,-84,-97,-89,
+  -61,-19,28,69,94,99,82,48,4,-41,-77,-99,-101,-83,-45,7,57,94,106,94,
+  63,23,-19,-58,-87,-100,-92,-61,-14,36,75,94,92,73,42,4,-34,-66,-83,-83,
+  -64,-31,7,42,67,77,72,52,22,-9,-36,-53,-59,-55,-42,-21,4,30,48,55,
+  49,35,17,0,-15,-28,-39,-44,-41,-29,-11,8,24,35,41,42,36,23,5,-16,
+  -35,-48,-54,-51,-38,-15,13,40,58,63,55,38,13,-15,-44,-69,-81,-76,-51,-13,
+  28,61,80,83,70,44,6,-35,-72,-95,-98,-79,-41,6,51,86,101,94,67,26,
+  -20,-61,-91,-103,-94,-65,-19,34,79,103,102,79,43,1,-40,-73,-94,-97,-77,-38,
+  12,57,85,93,82,57,22,-15,-50,-74,-83,-73,-47,-12,23,53,70,73,61,37,
+  7,-21,-43,-54,-55,-48,-33,-12,13,36,49,51,42,27,11,-4,-17,-31,-41,-45,
+  -39,-25,-7,12,27,38,44,43,34,18,-3,-24,-43,-55,-58,-50,-31,-4,27,52,
+  66,65,51,29,0,-31,-60,-80,-84,-69,-35,8,47,75,86,81,60,26,-15,-56,
+  -87,-101,-92,-62,-18,31,72,98,101,83,47,2,-43,-79,-99,-101,-81,-42,9,59,
+  94,105,92,61,21,-21,-58,-84,-96,-87,-58,-12,35,72,89,87,69,39,4,-32,
+  -61,-77,-77,-59,-29,5,36,59,70,66,49,23,-6,-30,-45,-52,-50,-41,-25,-3,
+  21,39,48,46,35,22,8,-6,-20,-34,-43,-45,-37,-21,-2,17,32,43,47,44,
+  31,12,-12,-34,-52,-61,-59,-46,-21,11,42,63,70,63,44,16,-15,-47,-74,-87,
+  -82,-56,-15,30,65,85,88,74,45,6,-37,-75,-99,-101,-80,-41,8,54,89,103,
+  95,66,24,-22,-63,-92,-102,-93,-63,-16,36,79,102,100,77,41,-1,-40,-72,-91,
+  -92,-73,-35,12,54,81,88,77,53,21,-14,-46,-68,-76,-67,-44,-13,19,45,62,
+  66,57,36,10,-16,-35,-46,-49,-45,-34,-17,4,26,41,46,41,30,18,5,-9,
+  -24,-38,-46,-45,-34,-17,3,22,38,48,50,43,26,3,-22,-45,-60,-65,-58,-38,
+  -8,27,56,72,72,57,33,1,-33,-64,-85,-90,-73,-37,8,51,80,91,85,62,
+  26,-17,-59,-91,-104,-94,-62,-16,33,75,100,102,83,46,0,-44,-80,-99,-99,-79,
+  -40,11,59,93,103,89,58,19,-21,-56,-81,-91,-82,-54,-11,34,68,84,82,64,
+  37,4,-29,-55,-70,-70,-55,-29,2,30,51,62,60,46,24,-1,-23,-37,-44,-45,
+  -40,-29,-11,11,30,42,43,37,27,16,2,-13,-30,-43,-49,-45,-31,-11,10,29,
+  45,53,52,39,18,-8,-34,-55,-67,-67,-54,-27,9,44,69,77,69,48,18,-16,
+  -51,-79,-93,-87,-59,-15,32,69,90,92,76,46,5,-40,-78,-101,-103,-81,-40,10,
+  57,91,104,95,65,23,-23,-64,-91,-101,-90,-60,-14,36,78,100,97,74,38,-2,
+  -39,-69,-86,-87,-68,-33,11,51,75,82,72,50,20,-12,-41,-61,-69,-62,-42,-15,
+  13,37,54,59,53,36,13,-9,-27,-38,-43,-43,-37,-24,-5,16,33,41,41,35,
+  25,13,-1,-19,-36,-49,-52,-43,-26,-4,18,38,52,57,51,33,7,-21,-47,-66,
+  -73,-66,-45,-11,28,60,78,78,63,36,2,-35,-68,-91,-95,-77,-39,9,54,84,
+  96,88,63,26,-19,-61,-93,-106,-95,-61,-14,36,77,101,102,81,44,-2,-46,-80,
+  -98,-97,-76,-37,12,59,91,99,85,55,17,-21,-54,-77,-86,-77,-50,-11,31,62,
+  78,76,60,35,5,-25,-49,-63,-64,-51,-29,-3,22,42,54,55,44,26,4,-15,
+  -29,-37,-42,-41,-34,-19,1,21,36,42,40,33,24,11,-7,-26,-44,-54,-53,-40,
+  -20,4,28,47,59,59,47,23,-6,-35,-60,-74,-75,-61,-31,8,47,74,84,75,
+  52,20,-17,-54,-83,-98,-91,-61,-15,35,74,94,95,78,45,3,-42,-80,-103,-103,
+  -80,-38,12,59,92,104,94,63,21,-25,-64,-90,-98,-86,-56,-12,36,76,96,93,
+  70,35,-3,-38,-65,-80,-81,-64,-31,10,46,69,75,66,47,20,-8,-35,-54,-61,
+  -56,-40,-17,7,29,45,52,49,36,17,-2,-18,-30,-37,-41,-40,-31,-15,6,25,
+  38,42,39,33,22,6,-14,-36,-52,-58,-52,-35,-11,15,39,57,64,58,39,11,
+  -21,-50,-71,-80,-73,-50,-13,29,65,84,84,67,38,1,-37,-72,-95,-99,-80,-39,
+  11,58,88,99,89,63,24,-21,-64,-95,-106,-94,-60,-12,38,78,101,101,79,42,
+  -3,-46,-78,-95,-93,-72,-34,13,57,87,95,81,52,16,-20,-51,-72,-80,-72,
+};
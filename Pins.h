@@ -8,6 +8,9 @@
 
 #define PIN_SW_ALARM    13
 #define PIN_PWM_BUZZER  10  // Note: Buzzer is actually *active*, PWM is N/A
+// Optional, the DS3231's INT/SQW output (open drain, active low). With CONFIG_RTC_ALARM, the alarm flag is
+// only read when it's low, otherwise it's read once a minute
+//#define PIN_RTC_INT     A5
 
 //   *** Schematic ***
 //   
@@ -4,7 +4,7 @@
 
 // real time clock
 RTC rtc;
-SoftwareI2C softWire;
+FastI2C softWire;
 
 #define RTC_DS1307_I2C_ADDRESS 0x68
 
@@ -15,13 +15,15 @@ RTC::RTC():
     m_DayOfWeek(1), 
     m_DayOfMonth(1),
     m_Month(1),
-    m_Year(12)
+    m_Year(12),
+    m_MinuteBCD(0),
+    m_MinuteTransaction{RTC_DS1307_I2C_ADDRESS, 0x01, &m_MinuteBCD, 1, true, I2C_IDLE}
 {
 }
 
 void RTC::setup(void)
 {
-  softWire.begin(PIN_RTC_SDA, PIN_RTC_SCL);
+  softWire.begin();
   ReadTime(true);
 }
 
@@ -35,31 +37,18 @@ byte RTC::Dec2BCD(byte Dec)
   return (Dec/10*16) + (Dec % 10);
 }
 
-void RTC::ReadTime(bool Full)
+bool RTC::ReadTime(bool Full)
 {
+  I2C_SITE(I2CSiteRTCTime);
+  // Full, from register 0, else just the minutes and hours, from register 1
+  // In one burst, so a failure part way (a NACK, or SCL held low) leaves the time unchanged
+  byte registers[7];
+  if (!softWire.ReadRegisters(RTC_DS1307_I2C_ADDRESS, Full?0x00:0x01, Full?registers:registers + 1, Full?7:2))
+    return false;
   if (Full)
-  {
-    // from register 0
-    softWire.beginTransmission(RTC_DS1307_I2C_ADDRESS);
-    softWire.write((byte)0x00);
-    softWire.endTransmission();
-   
-    softWire.requestFrom(RTC_DS1307_I2C_ADDRESS, 7);
-   
-    m_Second = BCD2Dec(softWire.read() & 0x7F);  // high bit is CH (Clock Halt)
-  }
-  else
-  {
-    // just the minutes and hours
-    // from register 1
-    softWire.beginTransmission(RTC_DS1307_I2C_ADDRESS);
-    softWire.write((byte)0x01);
-    softWire.endTransmission();
-   
-    softWire.requestFrom(RTC_DS1307_I2C_ADDRESS, 2);
-  }
-  m_Minute = BCD2Dec(softWire.read());
-  byte Register2 = softWire.read();
+    m_Second = BCD2Dec(registers[0] & 0x7F);  // high bit is CH (Clock Halt)
+  m_Minute = BCD2Dec(registers[1]);
+  byte Register2 = registers[2];
   if (Register2 & 0x40)  // 12/24 hr
   {
     // 12 hr mode, bit 6=PM
@@ -78,15 +67,17 @@ void RTC::ReadTime(bool Full)
   
   if (Full)
   {
-    m_DayOfWeek  = BCD2Dec(softWire.read());
-    m_DayOfMonth = BCD2Dec(softWire.read());
-    m_Month      = BCD2Dec(softWire.read());
-    m_Year       = BCD2Dec(softWire.read());
+    m_DayOfWeek  = BCD2Dec(registers[3]);
+    m_DayOfMonth = BCD2Dec(registers[4]);
+    m_Month      = BCD2Dec(registers[5]);
+    m_Year       = BCD2Dec(registers[6]);
   }
+  return true;
 }
 
 byte RTC::ReadSecond(void)
 {
+  I2C_SITE(I2CSiteRTCTime);
   // from register 01
   softWire.beginTransmission(RTC_DS1307_I2C_ADDRESS);
   softWire.write(0x00);
@@ -100,6 +91,7 @@ byte RTC::ReadSecond(void)
 
 byte RTC::ReadMinute(void)
 {
+  I2C_SITE(I2CSiteRTCTime);
   // from register 01
   softWire.beginTransmission(RTC_DS1307_I2C_ADDRESS);
   softWire.write(0x01);
@@ -110,8 +102,28 @@ byte RTC::ReadMinute(void)
   return BCD2Dec(softWire.read());
 }
 
+void RTC::StartReadMinute(void)
+{
+  // queue reading register 01, see EndReadMinute
+  I2C_SITE(I2CSiteRTCMinute);
+  softWire.Queue(&m_MinuteTransaction);
+}
+
+bool RTC::EndReadMinute(byte& Minute)
+{
+  // true, with the minute, once the read queued by StartReadMinute is complete
+  if (m_MinuteTransaction.status == I2C_DONE)
+  {
+    m_MinuteTransaction.status = I2C_IDLE;
+    Minute = BCD2Dec(m_MinuteBCD);
+    return true;
+  }
+  return false;
+}
+
 void RTC::WriteTime(void)
 {
+   I2C_SITE(I2CSiteRTCTime);
    softWire.beginTransmission(RTC_DS1307_I2C_ADDRESS);
    softWire.write((byte)0x00);
    softWire.write(Dec2BCD(m_Second));
@@ -126,6 +138,7 @@ void RTC::WriteTime(void)
 
 byte RTC::ReadByte(byte Index)
 {
+  I2C_SITE(I2CSiteRTCRegisters);
   softWire.beginTransmission(RTC_DS1307_I2C_ADDRESS);
   softWire.write(Index);
   softWire.endTransmission();
@@ -136,12 +149,27 @@ byte RTC::ReadByte(byte Index)
 
 void RTC::WriteByte(byte Index, byte Value)
 {
+   I2C_SITE(I2CSiteRTCRegisters);
    softWire.beginTransmission(RTC_DS1307_I2C_ADDRESS);
    softWire.write(Index);
    softWire.write(Value);
    softWire.endTransmission();
 }
 
+bool RTC::ReadBytes(byte Index, byte* pData, byte Count)
+{
+  // burst read, true if ACKed
+  I2C_SITE(I2CSiteRTCRegisters);
+  return softWire.ReadRegisters(RTC_DS1307_I2C_ADDRESS, Index, pData, Count);
+}
+
+bool RTC::WriteBytes(byte Index, const byte* pData, byte Count)
+{
+  // burst write, true if ACKed
+  I2C_SITE(I2CSiteRTCRegisters);
+  return softWire.WriteRegisters(RTC_DS1307_I2C_ADDRESS, Index, pData, Count);
+}
+
 byte RTC::ReadTemperature()
 {
   // NOT for DS1307
@@ -157,4 +185,33 @@ byte RTC::ReadTemperature()
     Temperature++;
   }
   return Temperature;
-}  
+}
+
+#define RTC_DS3231_ALARM1   0x07
+#define RTC_DS3231_CONTROL  0x0E
+#define RTC_DS3231_STATUS   0x0F
+#define RTC_DS3231_A1IE     0x01  // control, Alarm 1 asserts INT
+#define RTC_DS3231_INTCN    0x04  // control, INT not SQW
+#define RTC_DS3231_A1F      0x01  // status, Alarm 1 matched
+bool RTC::SetAlarm(byte Hour24, byte Minute)
+{
+  // NOT for DS1307
+  // A1M1..3 clear, A1M4 set: match seconds, minutes & hours (24 hour mode), i.e. daily
+  byte alarm[4] = {0x00, Dec2BCD(Minute), Dec2BCD(Hour24), 0x80};
+  if (!WriteBytes(RTC_DS3231_ALARM1, alarm, sizeof(alarm)))
+    return false;
+  WriteByte(RTC_DS3231_CONTROL, ReadByte(RTC_DS3231_CONTROL) | RTC_DS3231_A1IE | RTC_DS3231_INTCN);
+  // A1F is left alone, an alarm that's just gone off is still seen by CheckAlarm()
+  return true;
+}
+
+bool RTC::CheckAlarm()
+{
+  // NOT for DS1307
+  // A1F stays set until cleared, so it can't be missed, only seen late
+  byte status = ReadByte(RTC_DS3231_STATUS);
+  if (!(status & RTC_DS3231_A1F))
+    return false;
+  WriteByte(RTC_DS3231_STATUS, status & ~RTC_DS3231_A1F);
+  return true;
+}
@@ -1,11 +1,14 @@
 #ifndef rtc_h
 #define rtc_h
-#include <SoftwareI2C.h>
+#include "FastI2C.h"
 
 // Talk to the DS1307/DS3232
 
 // 0x14..0x3F should be safe to read/write on either:
 #define RTC_RAM_BASE_INDEX 0x14
+// How it's used:
+#define RTC_RAM_READINGS_INDEX   (RTC_RAM_BASE_INDEX +  0) // Weather's pressure readings, 16 bytes
+#define RTC_RAM_AGGREGATES_INDEX (RTC_RAM_BASE_INDEX + 16) // Weather's daily aggregates, 23 bytes
 
 class RTC
 {
@@ -14,14 +17,21 @@ class RTC
     void setup();
     byte BCD2Dec(byte BCD);
     byte Dec2BCD(byte Dec);
-    void ReadTime(bool Full);
+    bool ReadTime(bool Full);  // false (and the time unchanged) if the RTC didn't respond
     byte ReadSecond(void);
     byte ReadMinute(void);
+    void StartReadMinute(void);           // in the background
+    bool EndReadMinute(byte& Minute);     // true if the background read is complete
     void WriteTime(void);
     byte ReadByte(byte Index);
     void WriteByte(byte Index, byte Value);
+    bool ReadBytes(byte Index, byte* pData, byte Count);
+    bool WriteBytes(byte Index, const byte* pData, byte Count);
     
     byte ReadTemperature();
+    // DS3231/DS3232 Alarm 1
+    bool SetAlarm(byte Hour24, byte Minute);  // daily, at Hour24:Minute:00, with INT asserted. false if the RTC didn't respond
+    bool CheckAlarm();                        // true if the alarm has gone off (once, it clears the flag)
     
     byte m_Hour24;      // 0..23
     byte m_Minute;      // 0..59
@@ -30,9 +40,13 @@ class RTC
     byte m_DayOfMonth;  // 1..31
     byte m_Month;       // 1..12
     byte m_Year;        // 0..99
+
+  private:
+    byte m_MinuteBCD;
+    I2CTransaction m_MinuteTransaction;
 };
 
 extern RTC rtc;
-extern SoftwareI2C softWire;
+extern FastI2C softWire;
 
 #endif
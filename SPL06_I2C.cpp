@@ -4,7 +4,7 @@
 
 // A simple implementation of SPL06-007 pressure/temperature reading
 // Based on https://github.com/rv701/SPL06-007, which at time of writing (Nov '23) is broken.
-// Uses SoftwareI2C because the LCD shield uses SDA & SCL
+// Uses FastI2C (softWire) because the LCD shield uses SDA & SCL
 
 namespace SPL06_I2C
 {
@@ -16,15 +16,19 @@ enum RegisterIndices {PSR_B2, PSR_B1, PSR_B0,
 
 // Oversampling
 //  bits    value      scale    scale hex    
-//  0b0000:    1x     524288   0x00080000
-//  0b0001:    2x    1572864   0x00180000
-//  0b0010:    4x    3670016   0x00380000
-//  0b0011:    8x    7864320   0x00780000
+//  0b0000:    1x     524288   0x00080000   1*2^19
+//  0b0001:    2x    1572864   0x00180000   3*2^19
+//  0b0010:    4x    3670016   0x00380000   7*2^19
+//  0b0011:    8x    7864320   0x00780000  15*2^19
 //  Higher values use FIFO, untested
 
 // 8x from above
 #define OVERSAMPLE_BITS   0b0011
-#define OVERSAMPLE_SCALE 7864320.0
+#define OVERSAMPLE_SCALE_2_19 15  // the scale is this times 2^19
+
+// The compensation is done in 64-bit fixed point, with 20 fractional bits (Q20)
+// The raw values scaled to Q20 are raw*2^20/(OVERSAMPLE_SCALE_2_19*2^19), no division by the full scale needed
+#define Q 20
   
 void Write(uint8_t idx, uint8_t value)
 {
@@ -46,9 +50,9 @@ uint8_t Read(uint8_t idx)
   return softWire.read();
 }
 
-int32_t ReadValue(uint8_t I, uint8_t N, uint8_t M = 0)
+int32_t Extract(const uint8_t* bytes, uint8_t N, uint8_t M = 0)
 {
-  // Read a 24 or 16 bit value, MSB first, starting with the I'th register byte
+  // Take a 24 or 16 bit value, MSB first, from bytes
   // Then, starting at bit M, extract N bits as a 2's complement value
   // Convert that to 32 bit 2's complement value
 
@@ -58,7 +62,7 @@ int32_t ReadValue(uint8_t I, uint8_t N, uint8_t M = 0)
   uint32_t val = 0UL;
   uint8_t P = (N > 16)?3:2;
   for (int idx = 0; idx < P; idx++)
-    val = (val << 8) | Read(I + idx);
+    val = (val << 8) | bytes[idx];
      
   uint32_t hiBit = 1UL << N;
   uint32_t mask  = hiBit - 1UL;
@@ -76,42 +80,84 @@ int32_t ReadValue(uint8_t I, uint8_t N, uint8_t M = 0)
   return (int32_t)val;
 }
 
+int32_t ReadValue(uint8_t I, uint8_t N, uint8_t M = 0)
+{
+  // Read a value starting with the I'th register byte, see Extract()
+  uint8_t bytes[3];
+  softWire.ReadRegisters(SPL06_I2C_ADDR, I, bytes, (N > 16)?3:2);  // burst
+  return Extract(bytes, N, M);
+}
+
+// The calibration coefficients, read once
+int32_t c0, c1, c00, c10, c01, c11, c20, c21, c30;
+
+// The raw readings, PSR_B2..TMP_B0, read in the background
+uint8_t results[6];
+I2CTransaction resultsTransaction = {SPL06_I2C_ADDR, PSR_B2, results, sizeof(results), true, I2C_IDLE};
+
 void Init()
 {
   // Init the device
+  I2C_SITE(I2CSiteSensorInit);
   Write(PRS_CFG, OVERSAMPLE_BITS);               // 8x oversample, rate is N/A
   Write(TMP_CFG, 0b10000000 | OVERSAMPLE_BITS);  // External sensor, 8x oversample, rate is N/A
   Write(MEAS_CFG, 0b111);                        // continuous pressure and temperature reading
   Write(CFG_REG, 0x00);                          // no FIFO
+  
+  c0  = ReadValue(COEF +  0, 12, 4);
+  c1  = ReadValue(COEF +  1, 12);
+  c00 = ReadValue(COEF +  3, 20, 4);
+  c10 = ReadValue(COEF +  5, 20);  
+  c01 = ReadValue(COEF +  8, 16);
+  c11 = ReadValue(COEF + 10, 16); 
+  c20 = ReadValue(COEF + 12, 16);
+  c21 = ReadValue(COEF + 14, 16);
+  c30 = ReadValue(COEF + 16, 16);
 }
 
-// Note that we DON'T check *_RDY flags in MEAS_CFG
-double GetTemperatureC()
+void StartConversion()
 {
-  // temperature in Celcius
-  double c0 = ReadValue(COEF + 0, 12, 4);
-  double c1 = ReadValue(COEF + 1, 12);
-  
-  double scaledT = ReadValue(TMP_B2, 24)/OVERSAMPLE_SCALE;
+  // The device is in continuous mode, the result registers always hold the latest reading
+  // Just queue reading them
+  I2C_SITE(I2CSiteSensorSample);
+  softWire.Queue(&resultsTransaction);
+}
+
+bool IsReady()
+{
+  // true once the results have been read
+  return resultsTransaction.status == I2C_DONE;
+}
 
-  return ((c0/2.0) + (c1*scaledT));
+int32_t Scaled(uint8_t idx)
+{
+  // The 24-bit raw result at idx, scaled, Q20. At most about +/-2^20
+  return Extract(results + idx, 24)*2/OVERSAMPLE_SCALE_2_19;
 }
 
-double GetPressurePa()
+// Note that we DON'T check *_RDY flags in MEAS_CFG
+int16_t GetTemperatureDeciC()
+{
+  // temperature in tenths of a degree Celcius
+  // c0/2 + c1*scaledT
+  int64_t T = ((int64_t)(5*c0) << Q) + 10*(int64_t)c1*Scaled(TMP_B2);
+  return (T + (1L << (Q - 1))) >> Q;
+}
+
+int32_t GetPressurePa()
 {
   // pressure in Pascals
-  double c00 = ReadValue(COEF +  3, 20, 4);
-  double c10 = ReadValue(COEF +  5, 20);  
-  double c01 = ReadValue(COEF +  8, 16);
-  double c11 = ReadValue(COEF + 10, 16); 
-  double c20 = ReadValue(COEF + 12, 16);
-  double c21 = ReadValue(COEF + 14, 16);
-  double c30 = ReadValue(COEF + 16, 16);
-  
-  double scaledT  = ReadValue(TMP_B2, 24)/OVERSAMPLE_SCALE;
-  double scaledP  = ReadValue(PSR_B2, 24)/OVERSAMPLE_SCALE;
-  
-  return c00 + scaledP*(c10 + scaledP*(c20 + scaledP*c30)) + scaledT*(c01 + scaledP*(c11 + scaledP*c21));
+  // c00 + scaledP*(c10 + scaledP*(c20 + scaledP*c30)) + scaledT*(c01 + scaledP*(c11 + scaledP*c21))
+  // Each term is Q20, the largest intermediate is about 2^60
+  int64_t scaledT = Scaled(TMP_B2);
+  int64_t scaledP = Scaled(PSR_B2);
+  int64_t P = ((int64_t)c20 << Q) + c30*scaledP;
+  P = ((int64_t)c10 << Q) + ((P*scaledP) >> Q);
+  P = ((int64_t)c00 << Q) + ((P*scaledP) >> Q);
+  int64_t T = ((int64_t)c11 << Q) + c21*scaledP;
+  T = ((int64_t)c01 << Q) + ((T*scaledP) >> Q);
+  P += (T*scaledT) >> Q;
+  return (P + (1L << (Q - 1))) >> Q;
 }
   
 };
@@ -2,10 +2,12 @@
 
 #define SPL06_I2C_ADDR 0x76
 
-namespace SPL06_I2C  // SPL06-00x for Arduino, SoftwareI2C
+namespace SPL06_I2C  // SPL06-00x for Arduino, FastI2C
 {
-  // Does not init SoftwareI2C.  Temperature & Pressure 8x oversampling
+  // Does not init FastI2C.  Temperature & Pressure 8x oversampling
   void Init();
-  double GetTemperatureC();
-  double GetPressurePa();
+  void StartConversion();
+  bool IsReady();
+  int16_t GetTemperatureDeciC();  // 0.1C
+  int32_t GetPressurePa();
 };
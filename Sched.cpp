@@ -0,0 +1,52 @@
+#include <Arduino.h>
+#include <avr/sleep.h>
+#include "Config.h"
+#include "Sched.h"
+
+namespace Sched
+{
+unsigned long startMS[Num_Timers];
+uint16_t durationMS[Num_Timers];
+void (*pCallbacks[Num_Timers])();
+uint8_t running = 0;  // a bit per timer
+
+void Start(uint8_t timer, uint16_t ms, void (*pCallback)())
+{
+  startMS[timer] = millis();
+  durationMS[timer] = ms;
+  pCallbacks[timer] = pCallback;
+  running |= 1 << timer;
+}
+
+void Stop(uint8_t timer)
+{
+  running &= ~(1 << timer);
+}
+
+bool IsRunning(uint8_t timer)
+{
+  return running & (1 << timer);
+}
+
+void Loop()
+{
+  if (!running)
+    return;
+  unsigned long nowMS = millis();
+  for (uint8_t timer = 0; timer < Num_Timers; timer++)
+    if ((running & (1 << timer)) && (nowMS - startMS[timer]) >= durationMS[timer])
+    {
+      running &= ~(1 << timer);  // before the callback, which may restart it
+      pCallbacks[timer]();
+    }
+}
+
+void Idle()
+{
+#ifdef CONFIG_IDLE_SLEEP
+  // Idle keeps the clocks running (Timer0 for millis, Timer1, Timer2, the ADC), the deeper modes would stop them
+  set_sleep_mode(SLEEP_MODE_IDLE);
+  sleep_mode();
+#endif
+}
+};
@@ -0,0 +1,22 @@
+#pragma once
+
+// One-shot timers, run cooperatively from loop(). Rather than delay(), start a timer and carry on, the callback does the rest
+namespace Sched
+{
+  enum Timers
+  {
+    SplashTimer,
+    FlashTimer,      // flashing the DLS state
+    TouchHoldTimer,
+    BlinkTimer,      // the editor's blinking field
+    IdleTimer,       // the editor gives up
+    
+    Num_Timers
+  };
+
+  void Start(uint8_t timer, uint16_t ms, void (*pCallback)());  // (re)starts it
+  void Stop(uint8_t timer);
+  bool IsRunning(uint8_t timer);
+  void Loop();  // calls back the expired timers
+  void Idle();  // nothing more to do this pass, sleep until the next interrupt
+};
@@ -1,19 +1,22 @@
 #include <Arduino.h>
 
 // BMP280 or SPL06-00x pressure and temperature sensor
-// * * N O T E * *   
-// BMP280 not supported because we can't use Wire, using SoftwareI2C instead
+// Both use FastI2C (softWire), because the LCD shield uses SDA & SCL
 
 //#define SENSOR_BMP
 #ifdef SENSOR_BMP
-#include <BMP280_DEV.h> 
+#include "BMP280_I2C.h"
+namespace Sensor = BMP280_I2C;
 #else
 #include "SPL06_I2C.h"
+namespace Sensor = SPL06_I2C;
 #endif
 
 #include "Clock.h"
 #include "Config.h"
 #include "RTC.h"
+#include "Calendar.h"
+#include "History.h"
 #include "Weather.h"
 
 namespace Weather// FOR ENTERTAINMENT ONLY!
@@ -33,30 +36,36 @@ namespace Weather// FOR ENTERTAINMENT ONLY!
 //  * to sea level, if CONFIG_ALTITUDE_METERS is defined
 //  * to local range if CONFIG_MIN_PRESSURE_HPA & CONFIG_MAX_PRESSURE_HPA are defined
 //    Note that the Forecaster is based on UK conditions, the above step (unused!) is perhaps able to compensate slightly.
-// The result is used as the current pressure, and the trend is calculated from the reading 3 hours ago.
-// Readings are taken on the hour and half hour.
+// The result is used as the current pressure, the trend is estimated from the readings every minute (see FeedTrend).
+// Readings are also kept on the hour and half hour, and the forecast updated.
+// The readings are also saved in the RTC's (battery-backed) RAM, and restored at start-up if they're recent enough,
+// so there's a forecast straight away after a reset or power loss.
 // The conversion of the current pressure to a letter, for a given trend, is done via the p<Trend>PressureTable[]'s below.
 // Summer/Winter is applied as an extra step forward or backward in those tables.
+// The tables are expanded at compile time into direct indexes by pressure, with the seasonal step already applied.
 // Wind is ignored.
 // The forecast is shown by the clock as either the text, or an icon.
 // For the icon, the assumption is that they go from left to right from good to bad, and so do the letters A-Z
-// All pressures are in deca Pascals, dPa = hPa*10  In other words, 1 DP of pressure in hPa. Temperatures are in C
+// All pressures are in deca Pascals, dPa = hPa*10  In other words, 1 DP of pressure in hPa. Temperatures are in 0.1C
+// It's all integer arithmetic, no floating point
 
-typedef int16_t tPressure;  // dPa
+// The sensor is read asynchronously: a conversion is started, polled from the main loop (Sample()) and the result kept.
+// The minute tick (Loop()) uses the most recent completed sample and requests the next, so it never waits on the sensor.
 
-// I2C pressure and temperature sensor
-#ifdef SENSOR_BMP
-BMP280_DEV bmp280;
-#endif
+typedef int16_t tPressure;  // dPa
 
 const tPressure kNullPressure = 0;  // Don't have a value
 const tPressure kPressureTrendThreshold = 16; // i.e. 1.6hPa
+const tPressure kPressureTrendHysteresis = 4; // 0.4hPa, a Rising or Falling trend is kept until it's this far inside the threshold
+const tPressure kForecastHysteresis = 5;      // 0.5hPa, a forecast letter is kept until the pressure is this far past its boundary
+const int kTemperatureHysteresis = 2;         // 0.2C, past the rounding, before the temperature changes
 // The algorithm works with pressures in this range
 const tPressure ZambrettiMinPressure =  9470;
 const tPressure ZambrettiMaxPressure = 10500;
 
 int loopMinute = -9999;
-int currentTemperature = 0;
+int16_t currentTemperature = 0;  // 0.1C
+int shownTemperature = 0;  // C, with hysteresis
 tPressure currentPressure = kNullPressure;  // unadjusted
 tPressure adjustedPressure = kNullPressure;  // adjusted for MSL and range. Used in forecast
 char currentForecastLetter = '?';
@@ -64,8 +73,21 @@ char currentTrendLetter = '?';
 
 #define NUM_READINGS 6  // 3 hours worth, every half hour
 tPressure pressureReadings[NUM_READINGS];  // [0] is oldest. Adjusted
+uint32_t readingsHalfHour = 0;  // when pressureReadings[NUM_READINGS - 1] was taken, half hours since 1/1/2000
+// In the RTC RAM: readingsHalfHour (3 bytes, LSB first), pressureReadings (LSB first), checksum
+#define READINGS_RAM_SIZE (3 + 2*NUM_READINGS + 1)
 uint32_t kReadingTimeoutMS = 50UL;
 
+// The state of the sensor conversion
+enum SampleState {SampleIdle, SampleConverting};
+SampleState sampleState = SampleIdle;
+bool sampleRequested = false;
+uint32_t sampleStartMS = 0;
+// The most recent completed sample, sampleFresh until it's used
+bool sampleFresh = false;
+int16_t sampleTemperature = 0;  // 0.1C
+tPressure samplePressure = kNullPressure;
+
 // A '\n' denotes a line break
 //            123456789012345678901234 (24 chars per line)
 #define FORECASTS \
@@ -136,74 +158,165 @@ const char* GetForecastStr(char letter)
   return nullptr;
 }
 
-bool ReadPressure(tPressure& P)
+void Sample()
 {
-  // read raw pressure. BMP BLOCKS
-  float p;
-#ifdef SENSOR_BMP
-  bmp280.startForcedConversion();
-  uint32_t startMS = millis();
-  while (!bmp280.getPressure(p))
+  // Service the sensor, call often. Starts a requested conversion, collects the result when it's ready. Never blocks
+  if (sampleState == SampleIdle)
   {
-    if ((millis() - startMS) > kReadingTimeoutMS)
+    if (sampleRequested)
     {
-      bmp280.stopConversion();
-      return false;
+      sampleRequested = false;
+      Sensor::StartConversion();
+      sampleStartMS = millis();
+      sampleState = SampleConverting;
     }
-  }  
-#else
-  p = SPL06_I2C::GetPressurePa()/100.0;  // returns mB == hPa
-#endif  
-  P = 10.0*p + 0.5;
-  return true;
+  }
+  else if (Sensor::IsReady())
+  {
+    sampleTemperature = Sensor::GetTemperatureDeciC();
+    samplePressure = (Sensor::GetPressurePa() + 5)/10;  // Pa -> dPa
+    sampleFresh = true;
+    sampleState = SampleIdle;
+  }
+  else if ((millis() - sampleStartMS) > kReadingTimeoutMS)
+  {
+    sampleState = SampleIdle;  // give up, keep the previous sample
+  }
 }
 
-bool ReadTemperature(int& T)
+#ifdef CONFIG_ALTITUDE_METERS  
+// The sea level factor is (1 - L*h/(T + L*h + 273.15))^-5.257, L = 0.0065K/m, h = altitude, T = temperature, C
+// It's pre-computed at compile time, for every MSL_STEP_C degrees, as the fraction over 1, *65536 (so good for a factor under 2)
+// pow() is not constexpr, so it's exp(-5.257*ln(1 - u)), from their series, for u = L*h/(T + L*h + 273.15) (small)
+constexpr double LnSeries(double u, double term, int n)
 {
-  // read raw temperature. BMP BLOCKS
-  float t;
-#ifdef SENSOR_BMP
-  bmp280.startForcedConversion();
-  uint32_t startMS = millis();
-  while (!bmp280.getTemperature(t))
-  {
-    if ((millis() - startMS) > kReadingTimeoutMS)
-    {
-      bmp280.stopConversion();
-      return false;
-    }
-  }
-#else
-  t = SPL06_I2C::GetTemperatureC();
-#endif
-  T = t + 0.5;
-  return true;
+  // u/1 + u^2/2 + u^3/3 ... == -ln(1 - u)
+  return (n > 20)?0.0:term/n + LnSeries(u, term*u, n + 1);
 }
 
+constexpr double ExpSeries(double x, double term, int n)
+{
+  // 1 + x + x^2/2! + x^3/3! ... == exp(x)
+  return (n > 20)?term:term + ExpSeries(x, term*x/n, n + 1);
+}
+
+constexpr double MSLFactorU(int temperatureC)
+{
+  return (0.0065*CONFIG_ALTITUDE_METERS)/(temperatureC + 0.0065*CONFIG_ALTITUDE_METERS + 273.15);
+}
+
+constexpr uint16_t MSLFactor(int temperatureC)
+{
+  // -5.257*ln(1 - u) is +5.257*LnSeries
+  return (ExpSeries(5.257*LnSeries(MSLFactorU(temperatureC), MSLFactorU(temperatureC), 1), 1.0, 1) - 1.0)*65536.0 + 0.5;
+}
+
+#define MSL_MIN_C  -20
+#define MSL_STEP_C   5
+const uint16_t pMSLFactors[] PROGMEM = {MSLFactor(-20), MSLFactor(-15), MSLFactor(-10), MSLFactor(-5), MSLFactor( 0), 
+                                        MSLFactor(  5), MSLFactor( 10), MSLFactor( 15), MSLFactor(20), MSLFactor(25), 
+                                        MSLFactor( 30), MSLFactor( 35), MSLFactor( 40), MSLFactor(45), MSLFactor(50)};
+#define MSL_NUM_FACTORS (sizeof(pMSLFactors)/sizeof(pMSLFactors[0]))
+#endif
+
 tPressure AdjustedPressure(tPressure pressure)
 {
-  // Adjust to sea level
+  // Adjust to sea level, then map to range
+  if (pressure == kNullPressure)
+    return kNullPressure;
 #ifdef CONFIG_ALTITUDE_METERS  
-  float pressure_hPa = pressure/10.0;
-  return (tPressure)(0.5 + 10*pressure_hPa * pow(1.0 - (0.0065 * CONFIG_ALTITUDE_METERS) / (currentTemperature + (0.0065 * CONFIG_ALTITUDE_METERS) + 273.15), -5.257));
-#else
-  return pressure;
+  // Interpolate the factor for the current temperature
+  int16_t T = constrain(currentTemperature, 10*MSL_MIN_C, 10*(MSL_MIN_C + MSL_STEP_C*(int)(MSL_NUM_FACTORS - 2)));
+  T -= 10*MSL_MIN_C;
+  int idx = T/(10*MSL_STEP_C);
+  int32_t factor0 = pgm_read_word_near(pMSLFactors + idx);
+  int32_t factor1 = pgm_read_word_near(pMSLFactors + idx + 1);
+  int32_t factor = factor0 + ((factor1 - factor0)*(T % (10*MSL_STEP_C)))/(10*MSL_STEP_C);
+  pressure += (pressure*factor + 32768L) >> 16;
+#endif  
+#if defined(CONFIG_MIN_PRESSURE_HPA) && defined(CONFIG_MAX_PRESSURE_HPA)
+  // Map pressure to Zambretti range. Fixed point, the scale is *65536
+  const int32_t kRangeScale = ((int32_t)(ZambrettiMaxPressure - ZambrettiMinPressure) << 16)/((CONFIG_MAX_PRESSURE_HPA - CONFIG_MIN_PRESSURE_HPA)*10);
+  pressure = ZambrettiMinPressure + (((pressure - CONFIG_MIN_PRESSURE_HPA*10)*kRangeScale + 32768L) >> 16);
 #endif  
+  return pressure;
 }
 
-// 
+// The Forecaster's tables, <letters><NUL><pressures>. Only used at compile time, to generate the indexes below
 #define PRESSURE_OFFSET 947 // tables below store the difference from this, in a byte, hPa, at MSL
 #define P(_p) ((char)((_p) - PRESSURE_OFFSET))
 
 // Rising pressure
-const char pRisingPressureTable[]  PROGMEM = {    'A',     'B',     'C',     'F',     'G',     'I',     'J',     'L',     'M',     'Q',     'T',     'Y',     'Z',     '\0',
-                                              P(1030), P(1022), P(1012), P(1007), P(1000), P( 995), P( 990), P( 984), P( 978), P( 970), P( 965), P( 959), P( 947)};
+constexpr char pRisingPressureTable[]  = {    'A',     'B',     'C',     'F',     'G',     'I',     'J',     'L',     'M',     'Q',     'T',     'Y',     'Z',     '\0',
+                                          P(1030), P(1022), P(1012), P(1007), P(1000), P( 995), P( 990), P( 984), P( 978), P( 970), P( 965), P( 959), P( 947)};
 // Falling pressure
-const char pFallingPressureTable[] PROGMEM = {    'A',     'B',     'D',     'H',     'O',     'R',     'U',     'V',     'X',     '\0',
-                                              P(1050), P(1040), P(1024), P(1018), P(1010), P(1004), P( 998), P( 991), P( 985)};
+constexpr char pFallingPressureTable[] = {    'A',     'B',     'D',     'H',     'O',     'R',     'U',     'V',     'X',     '\0',
+                                          P(1050), P(1040), P(1024), P(1018), P(1010), P(1004), P( 998), P( 991), P( 985)};
 // Steady pressure
-const char pSteadyPressureTable[]  PROGMEM = {    'A',     'B',     'E',     'K',     'N',     'P',     'S',     'W',     'X',     'Z',     '\0',
-                                              P(1033), P(1023), P(1014), P(1008), P(1000), P( 994), P( 989), P( 981), P( 974), P( 960)};
+constexpr char pSteadyPressureTable[]  = {    'A',     'B',     'E',     'K',     'N',     'P',     'S',     'W',     'X',     'Z',     '\0',
+                                          P(1033), P(1023), P(1014), P(1008), P(1000), P( 994), P( 989), P( 981), P( 974), P( 960)};
+
+constexpr int TableLength(const char* pTable, int idx = 0)
+{
+  // the number of letters
+  return pTable[idx]?TableLength(pTable, idx + 1):idx;
+}
+
+constexpr tPressure TablePressure(const char* pTable, int idx)
+{
+  // the idx'th pressure
+  return 10*(pTable[TableLength(pTable) + 1 + idx] + PRESSURE_OFFSET);
+}
+
+constexpr tPressure Difference(tPressure a, tPressure b)
+{
+  return (a > b)?a - b:b - a;
+}
+
+constexpr int ClosestIndex(const char* pTable, tPressure pressure, int idx = 1, int closest = 0)
+{
+  // the index of the table pressure closest to pressure, the first one wins a tie
+  return (idx == TableLength(pTable))?closest:
+    ClosestIndex(pTable, pressure, idx + 1, 
+                 (Difference(pressure, TablePressure(pTable, idx)) < Difference(pressure, TablePressure(pTable, closest)))?idx:closest);
+}
+
+constexpr int SeasonalIndex(const char* pTable, int idx, int8_t seasonAdjustment)
+{
+  // step forward/back for the season, if there's room
+  return (seasonAdjustment == +1 && idx + 1 < TableLength(pTable))?idx + 1:
+         (seasonAdjustment == -1 && idx > 0)?idx - 1:idx;
+}
+
+constexpr char TableLetter(const char* pTable, tPressure pressure, int8_t seasonAdjustment)
+{
+  // The letter for the table pressure closest to pressure, adjusted for the season (+1/0/-1), or ' ' if below the table
+  return (pressure < TablePressure(pTable, TableLength(pTable) - 1))?' ':
+    pTable[SeasonalIndex(pTable, ClosestIndex(pTable, pressure), seasonAdjustment)];
+}
+
+// The tables are expanded into direct indexes, one letter per half hPa from ZambrettiMinPressure, so a forecast is a single read.
+// The table pressures are whole hPa, so the closest one only changes on a multiple of half a hPa (5 dPa) and the index gives
+// exactly the same letter as searching the table. Above the table's highest pressure is checked separately, see LookupForecast
+#define INDEX_STEP 5  // dPa
+#define INDEX_SIZE 208
+static_assert(ZambrettiMinPressure + INDEX_STEP*INDEX_SIZE > ZambrettiMaxPressure, "Forecast index too small");
+#define INDEX_1(_table, _adj, _i)  TableLetter(_table, ZambrettiMinPressure + INDEX_STEP*(_i), _adj),
+#define INDEX_4(_table, _adj, _i)  INDEX_1(_table, _adj, _i) INDEX_1(_table, _adj, _i + 1) INDEX_1(_table, _adj, _i + 2) INDEX_1(_table, _adj, _i + 3)
+#define INDEX_16(_table, _adj, _i) INDEX_4(_table, _adj, _i) INDEX_4(_table, _adj, _i + 4) INDEX_4(_table, _adj, _i + 8) INDEX_4(_table, _adj, _i + 12)
+#define INDEX(_table, _adj) { INDEX_16(_table, _adj,   0) INDEX_16(_table, _adj,  16) INDEX_16(_table, _adj,  32) INDEX_16(_table, _adj,  48) \
+                              INDEX_16(_table, _adj,  64) INDEX_16(_table, _adj,  80) INDEX_16(_table, _adj,  96) INDEX_16(_table, _adj, 112) \
+                              INDEX_16(_table, _adj, 128) INDEX_16(_table, _adj, 144) INDEX_16(_table, _adj, 160) INDEX_16(_table, _adj, 176) \
+                              INDEX_16(_table, _adj, 192) }
+
+const char pRisingIndex[INDEX_SIZE]        PROGMEM = INDEX(pRisingPressureTable,   0);
+const char pRisingSummerIndex[INDEX_SIZE]  PROGMEM = INDEX(pRisingPressureTable,  +1);
+const char pFallingIndex[INDEX_SIZE]       PROGMEM = INDEX(pFallingPressureTable,  0);
+const char pFallingWinterIndex[INDEX_SIZE] PROGMEM = INDEX(pFallingPressureTable, -1);
+const char pSteadyIndex[INDEX_SIZE]        PROGMEM = INDEX(pSteadyPressureTable,   0);
+constexpr tPressure kRisingMaxPressure  = TablePressure(pRisingPressureTable,  0);
+constexpr tPressure kFallingMaxPressure = TablePressure(pFallingPressureTable, 0);
+constexpr tPressure kSteadyMaxPressure  = TablePressure(pSteadyPressureTable,  0);
 
 // Seasons
 //                    DNOSAJJMAMFJ- 
@@ -217,46 +330,333 @@ bool IsWinter() { return JUN_JUL_AUG & (1 << rtc.m_Month); }
 bool IsSummer() { return DEC_JAN_FEB & (1 << rtc.m_Month); }
 #endif
 
-tPressure ReadTablePressure(const char* pPressures)
+char LookupForecast(tPressure currentPressureMSL, const char* pIndex, tPressure maxPressure)
 {
-  // read a pressure from one of the tables above
-  return 10*(pgm_read_byte_near(pPressures) + PRESSURE_OFFSET);
+  // pIndex is one of the indexes above, maxPressure its table's highest pressure
+  // Returns the letter corresponding to the table pressure closest to currentPressure, or ' ' if out of range
+  if (currentPressureMSL < ZambrettiMinPressure || currentPressureMSL > maxPressure)
+    return ' ';
+  return pgm_read_byte_near(pIndex + (currentPressureMSL - ZambrettiMinPressure)/INDEX_STEP);
 }
 
-char LookupForecast(tPressure currentPressureMSL, const char* pTable, int8_t seasonAdjustment)
+uint32_t Seconds()
 {
-  // pTable is <letters><NUL><offset pressures>
-  // Returns the letter corresponding to the table pressure closest to currentPressure
-  // seasonAdjustment is +1/0/-1
-  const char* pLetters = pTable;
-  const char* pPressures = pTable + strlen_P(pTable) + 1;
-  tPressure tablePressure = ReadTablePressure(pPressures++);
-  if (currentPressureMSL > tablePressure)
-    return ' '; // outside range
-  const char* pClosestLetter = pLetters++;
-  tPressure minDiff = abs(currentPressureMSL - tablePressure);
+  // The current time, seconds since 1/1/2000, to the minute. The full time must be read before calling
+  return Time::RTCSeconds();
+}
 
-  while (pgm_read_byte_near(pLetters))
+uint32_t LocalSeconds()
+{
+  // As displayed, with DLS
+  return Seconds() + Config::DLS*3600UL;
+}
+
+uint16_t Day()
+{
+  // The current local day, since 1/1/2000 (a Saturday), so the aggregates start again with the date
+  return LocalSeconds()/(24*3600UL);
+}
+
+uint32_t HalfHour()
+{
+  // The current half hour, since 1/1/2000
+  return Seconds()/1800UL;
+}
+
+void AgeReadings(uint32_t halfHour)
+{
+  // Shift the readings so the newest is for halfHour, any missed half hours are N/A
+  uint32_t age = halfHour - readingsHalfHour;  // (huge if the clock went backwards, so all N/A)
+  readingsHalfHour = halfHour;
+  for (int i = 0; i < NUM_READINGS; i++)
+    pressureReadings[i] = (age < (uint32_t)(NUM_READINGS - i))?pressureReadings[i + age]:kNullPressure;
+}
+
+byte Checksum(const byte* pData, int size, byte seed)
+{
+  // Of data saved in the RTC RAM
+  byte sum = seed;
+  while (size--)
+    sum += *pData++;
+  return ~sum;
+}
+
+void SaveReadings()
+{
+#ifdef CONFIG_SAVE_READINGS
+  // Save the readings in the RTC RAM
+  byte buffer[READINGS_RAM_SIZE];
+  byte* pData = buffer;
+  for (int b = 0; b < 3; b++)
+    *pData++ = readingsHalfHour >> 8*b;
+  for (int i = 0; i < NUM_READINGS; i++)
   {
-    tablePressure = ReadTablePressure(pPressures);
-    tPressure diff = abs(currentPressureMSL - tablePressure);
-    if (diff < minDiff)
+    *pData++ = pressureReadings[i];
+    *pData++ = pressureReadings[i] >> 8;
+  }
+  *pData = Checksum(buffer, sizeof(buffer) - 1, 'W');
+  rtc.WriteBytes(RTC_RAM_READINGS_INDEX, buffer, sizeof(buffer));
+#endif
+}
+
+void LoadReadings()
+{
+  // Restore the readings from the RTC RAM, if they're intact and not too old. The full time must be read before calling
+#ifdef CONFIG_SAVE_READINGS
+  byte buffer[READINGS_RAM_SIZE];
+  if (!rtc.ReadBytes(RTC_RAM_READINGS_INDEX, buffer, sizeof(buffer)) || Checksum(buffer, sizeof(buffer) - 1, 'W') != buffer[READINGS_RAM_SIZE - 1])
+    return;
+  const byte* pData = buffer;
+  readingsHalfHour = 0;
+  for (int b = 0; b < 3; b++)
+    readingsHalfHour |= (uint32_t)*pData++ << 8*b;
+  for (int i = 0; i < NUM_READINGS; i++, pData += 2)
+    pressureReadings[i] = pData[0] | (pData[1] << 8);
+  if ((HalfHour() - readingsHalfHour) >= NUM_READINGS)  // (or in the future)
+    for (int i = 0; i < NUM_READINGS; i++)
+      pressureReadings[i] = kNullPressure;
+#endif
+}
+
+// The pressure trend is estimated from every minute's adjusted pressure, by Holt's double exponential smoothing, fixed point.
+// The level follows the pressure, the slope (per minute) follows the change in the level.
+// One noisy sample moves the slope by 1/1024th of its error, not all of it as with the difference of two readings.
+// The noise is the mean absolute error of the one-minute-ahead prediction.
+#define TREND_Q 12                   // fractional bits
+#define TREND_ALPHA_SHIFT 4          // level += error/16
+#define TREND_ALPHA_BETA_SHIFT 10    // slope += error/1024
+#define TREND_NOISE_SHIFT 4          // noise += (|error| - noise)/16
+#define TREND_MINUTES 180            // the trend is per 3 hours, as for the Forecaster. Also the samples needed for a forecast
+int32_t trendLevel;  // dPa
+int32_t trendSlope;  // dPa/minute
+int32_t trendNoise;  // dPa
+uint16_t trendMinutes = 0;  // samples (or their equivalent), up to TREND_MINUTES. 0 means none
+
+void FeedTrend(tPressure pressure)
+{
+  // Update the estimate with the minute's adjusted pressure, O(1)
+  int32_t sample = (int32_t)pressure << TREND_Q;
+  if (!trendMinutes)
+  {
+    trendLevel = sample;
+    trendSlope = trendNoise = 0;
+  }
+  else
+  {
+    int32_t error = sample - (trendLevel + trendSlope);
+    trendLevel += trendSlope + (error >> TREND_ALPHA_SHIFT);
+    trendSlope += error >> TREND_ALPHA_BETA_SHIFT;
+    trendNoise += (((error < 0)?-error:error) - trendNoise) >> TREND_NOISE_SHIFT;
+  }
+  if (trendMinutes < TREND_MINUTES)
+    trendMinutes++;
+}
+
+void SeedTrend()
+{
+  // Start the estimate from the readings (restored from the RTC RAM), so there's a trend straight away
+  trendMinutes = 0;
+  tPressure newest = pressureReadings[NUM_READINGS - 1];
+  if (newest == kNullPressure)
+    return;
+  int oldest = 0;
+  while (pressureReadings[oldest] == kNullPressure)
+    oldest++;
+  trendLevel = (int32_t)newest << TREND_Q;
+  trendNoise = 0;
+  uint16_t minutes = 30*(NUM_READINGS - 1 - oldest);
+  trendSlope = minutes?((int32_t)(newest - pressureReadings[oldest]) << TREND_Q)/minutes:0;
+  // A full window of readings counts as TREND_MINUTES of samples, so UpdateForecast() has a forecast straight away
+  if (!oldest)
+    trendMinutes = TREND_MINUTES;
+  else
+    trendMinutes = minutes?minutes:1;
+}
+
+tPressure TrendPressure()
+{
+  // The change over TREND_MINUTES, dPa
+  return (trendSlope*TREND_MINUTES + (1L << (TREND_Q - 1))) >> TREND_Q;
+}
+
+uint8_t TrendConfidence()
+{
+  // 0..99%, how far the trend stands above the noise, scaled down until there are TREND_MINUTES of samples
+  // The slope's own noise over TREND_MINUTES is roughly 4x the sample noise, for the shifts above
+  int32_t trend = ((trendSlope < 0)?-trendSlope:trendSlope)*TREND_MINUTES;
+  int32_t total = trend + 4*trendNoise;
+  if (!total)
+    return 0;
+  int32_t confidence = (100*(trend >> 8)/((total >> 8) + 1))*trendMinutes/TREND_MINUTES;
+  return min(confidence, 99L);
+}
+
+char TrendLetter(tPressure trend)
+{
+  // Rising, Falling or Steady. Rising or Falling stick until the trend is back inside the threshold by the hysteresis
+  if (trend >= +kPressureTrendThreshold || (currentTrendLetter == 'R' && trend > +kPressureTrendThreshold - kPressureTrendHysteresis))
+    return 'R';
+  if (trend <= -kPressureTrendThreshold || (currentTrendLetter == 'F' && trend < -kPressureTrendThreshold + kPressureTrendHysteresis))
+    return 'F';
+  return 'S';
+}
+
+char TrendForecast(char trend, tPressure pressure)
+{
+  // The letter for the trend and pressure
+  if (trend == 'R')
+    return LookupForecast(pressure, IsSummer()?pRisingSummerIndex:pRisingIndex, kRisingMaxPressure);
+  if (trend == 'F')
+    return LookupForecast(pressure, IsWinter()?pFallingWinterIndex:pFallingIndex, kFallingMaxPressure);
+  return LookupForecast(pressure, pSteadyIndex, kSteadyMaxPressure);
+}
+
+void UpdateForecast()
+{
+  // The forecast, from the estimated pressure and trend
+  if (trendMinutes < TREND_MINUTES)
+  {
+    currentForecastLetter = '?';
+    return;
+  }
+  adjustedPressure = (trendLevel + (1L << (TREND_Q - 1))) >> TREND_Q;
+  char trend = TrendLetter(TrendPressure());
+  char forecast = TrendForecast(trend, adjustedPressure);
+  if (trend == currentTrendLetter && forecast != currentForecastLetter && 
+      (TrendForecast(trend, adjustedPressure - kForecastHysteresis) == currentForecastLetter || 
+       TrendForecast(trend, adjustedPressure + kForecastHysteresis) == currentForecastLetter))
+    forecast = currentForecastLetter;  // not far enough past the boundary
+  currentTrendLetter = trend;
+  currentForecastLetter = forecast;
+}
+
+void UpdateTemperature()
+{
+  // The temperature to show, rounded, but only changed once it's more than the hysteresis past the rounding
+  int16_t diff = currentTemperature - 10*shownTemperature;
+  if (diff > 5 + kTemperatureHysteresis || diff < -5 - kTemperatureHysteresis)
+    shownTemperature = (currentTemperature + ((currentTemperature < 0)?-5:+5))/10;
+}
+
+// Today's and this week's aggregates, [0] is temperature, [1] is pressure (adjusted)
+// A sample is added in O(1), at midnight they start again. Weeks start on Monday
+// Today's are optionally saved in the RTC RAM, compactly, as the mean and the count
+Aggregate dayAggregates[2];
+Aggregate weekAggregates[2];
+uint16_t aggregatesDay = 0;
+// In the RTC RAM: aggregatesDay, then per aggregate: min, max, mean, count (all LSB first), minAt, maxAt, then a checksum
+#define AGGREGATE_RAM_SIZE 10
+#define AGGREGATES_RAM_SIZE (2 + 2*AGGREGATE_RAM_SIZE + 1)
+
+int16_t Aggregate::Mean() const
+{
+  return count?(sum + ((sum < 0)?-(int32_t)count/2:(int32_t)count/2))/(int32_t)count:0;
+}
+
+uint16_t Week(uint16_t day)
+{
+  // The Monday-based week of the day since 1/1/2000
+  return (day + 5)/7;
+}
+
+void AddToAggregate(Aggregate& aggregate, int16_t value, uint8_t at)
+{
+  if (!aggregate.count || value < aggregate.min)
+  {
+    aggregate.min = value;
+    aggregate.minAt = at;
+  }
+  if (!aggregate.count || value > aggregate.max)
+  {
+    aggregate.max = value;
+    aggregate.maxAt = at;
+  }
+  aggregate.sum += value;
+  aggregate.count++;
+}
+
+void ClearAggregates(Aggregate* pAggregates)
+{
+  memset(pAggregates, 0, 2*sizeof(Aggregate));
+}
+
+void SaveAggregates()
+{
+#ifdef CONFIG_SAVE_AGGREGATES
+  // Save today's aggregates in the RTC RAM
+  byte buffer[AGGREGATES_RAM_SIZE];
+  byte* pData = buffer;
+  *pData++ = aggregatesDay;
+  *pData++ = aggregatesDay >> 8;
+  for (int idx = 0; idx < 2; idx++)
+  {
+    const Aggregate& aggregate = dayAggregates[idx];
+    int16_t values[] = {aggregate.min, aggregate.max, aggregate.Mean(), (int16_t)aggregate.count};
+    for (int v = 0; v < 4; v++)
     {
-      minDiff = diff;
-      pClosestLetter = pLetters;
+      *pData++ = values[v];
+      *pData++ = values[v] >> 8;
     }
-    pLetters++;
-    pPressures++;
+    *pData++ = aggregate.minAt;
+    *pData++ = aggregate.maxAt;
+  }
+  *pData = Checksum(buffer, sizeof(buffer) - 1, 'A');
+  rtc.WriteBytes(RTC_RAM_AGGREGATES_INDEX, buffer, sizeof(buffer));
+#endif
+}
+
+void LoadAggregates()
+{
+  // Restore today's aggregates from the RTC RAM, if they're intact and for today. Start the week's from them. The full time must be read before calling
+  aggregatesDay = Day();
+  ClearAggregates(dayAggregates);
+  ClearAggregates(weekAggregates);
+#ifdef CONFIG_SAVE_AGGREGATES
+  byte buffer[AGGREGATES_RAM_SIZE];
+  if (!rtc.ReadBytes(RTC_RAM_AGGREGATES_INDEX, buffer, sizeof(buffer)) || Checksum(buffer, sizeof(buffer) - 1, 'A') != buffer[AGGREGATES_RAM_SIZE - 1] ||
+      (buffer[0] | (buffer[1] << 8)) != aggregatesDay)
+    return;
+  const byte* pData = buffer + 2;
+  for (int idx = 0; idx < 2; idx++)
+  {
+    Aggregate& aggregate = dayAggregates[idx];
+    int16_t values[4];
+    for (int v = 0; v < 4; v++, pData += 2)
+      values[v] = pData[0] | (pData[1] << 8);
+    aggregate.min = values[0];
+    aggregate.max = values[1];
+    aggregate.count = values[3];
+    aggregate.sum = (int32_t)values[2]*aggregate.count;
+    aggregate.minAt = *pData++;
+    aggregate.maxAt = *pData++;
+    // the week's times are hours
+    weekAggregates[idx] = aggregate;
+    weekAggregates[idx].minAt = 24*((aggregatesDay + 5) % 7) + aggregate.minAt/6;
+    weekAggregates[idx].maxAt = 24*((aggregatesDay + 5) % 7) + aggregate.maxAt/6;
   }
-  if (currentPressureMSL < tablePressure)
-    return ' ';  // outside range
-    
-  if (seasonAdjustment == +1 && pgm_read_byte_near(pClosestLetter + 1))
-    pClosestLetter++;
-  else if (seasonAdjustment == -1 && pClosestLetter != pTable)
-    pClosestLetter--;
+#endif
+}
 
-  return pgm_read_byte_near(pClosestLetter);
+void UpdateAggregates(int16_t temperature, tPressure pressure)
+{
+  // Add the samples (kNullPressure if there's none), starting again at midnight. The full time must be read before calling
+  uint16_t day = Day();
+  if (day != aggregatesDay)
+  {
+    ClearAggregates(dayAggregates);
+    if (Week(day) != Week(aggregatesDay))
+      ClearAggregates(weekAggregates);
+    aggregatesDay = day;
+  }
+  if (pressure == kNullPressure)
+    return;
+  uint16_t minuteOfDay = (LocalSeconds() % (24*3600UL))/60;
+  uint8_t dayAt = minuteOfDay/10;
+  uint8_t weekAt = 24*((day + 5) % 7) + minuteOfDay/60;
+  AddToAggregate(dayAggregates[0], temperature, dayAt);
+  AddToAggregate(dayAggregates[1], pressure, dayAt);
+  AddToAggregate(weekAggregates[0], temperature, weekAt);
+  AddToAggregate(weekAggregates[1], pressure, weekAt);
 }
 
 void Init()
@@ -264,69 +664,79 @@ void Init()
   // N/A values
   for (int i = 0; i < NUM_READINGS; i++)
     pressureReadings[i] = kNullPressure;
-#ifdef SENSOR_BMP
-  bmp280.begin(BMP280_I2C_ALT_ADDR);
-#else
-  SPL06_I2C::Init();
-#endif  
-  ReadTemperature(currentTemperature);
-  ReadPressure(currentPressure);
+  rtc.ReadTime(true);
+  LoadReadings();
+  LoadAggregates();
+  SeedTrend();
+  UpdateForecast();
+  Sensor::Init();
+  // Wait for the first sample, only here
+  sampleRequested = true;
+  do
+    Sample();
+  while (sampleState != SampleIdle);
+  currentTemperature = sampleTemperature;
+  shownTemperature = (currentTemperature + ((currentTemperature < 0)?-5:+5))/10;
+  currentPressure = samplePressure;
 }
 
-void Loop()
+void Minute(int16_t temperature, int16_t pressure, bool fresh)
 {
-  // The full time must be read before calling, called once per minute
-  // Takes a pressure readings every half hour: on the hour and half past
+  // One minute's processing, of the given sample (0.1C, dPa), fresh if it's new since the last minute
+  // Loop() passes the sensor's, anything else (e.g. replaying logged readings) can pass its own.
+  // Only the state in RAM changes, Loop() saves it to the RTC RAM.
+  // The full time must be read before calling (the rtc fields may be set directly instead)
+  // Feeds the trend estimate every minute, keeps a reading every half hour: on the hour and half past
   // Pressure is adjusted
   //   to MSL
   //   for range
-  // Updates the forecast based on the current adjusted pressure and the trend from the most recent reading and one 3 hours ago (adjusted)
+  // Updates the forecast every half hour, based on the estimated adjusted pressure and its trend
+  // Adds the (adjusted) sample to the History every HISTORY_INTERVAL_MINUTES, if CONFIG_HISTORY
   // Based on
   // https://communities.sas.com/t5/Streaming-Analytics/Zambretti-Algorithm-for-Weather-Forecasting/td-p/679487
   // or https://integritext.net/DrKFS/zambretti.htm
-  
+  currentTemperature = temperature;
+  UpdateTemperature();
+  currentPressure = pressure;
+  tPressure adjusted = AdjustedPressure(currentPressure);
+  if (fresh && adjusted != kNullPressure)
+    FeedTrend(adjusted);
+  UpdateAggregates(temperature, fresh?adjusted:kNullPressure);
+#ifdef CONFIG_HISTORY
+  if (rtc.m_Minute % HISTORY_INTERVAL_MINUTES == 0)
+    History::Add(Seconds()/(60UL*HISTORY_INTERVAL_MINUTES), fresh?temperature:History::kMissing, (fresh && adjusted != kNullPressure)?adjusted:History::kMissing);
+#endif
+  if (rtc.m_Minute == 0 || rtc.m_Minute == 30)
+  {
+    AgeReadings(HalfHour());
+    pressureReadings[NUM_READINGS - 1] = adjusted;
+    UpdateForecast();
+  }
+}
+
+void Loop()
+{
+  // The full time must be read before calling, called once per minute
+  // Processes the most recent sample, and requests the next
   if (loopMinute != rtc.m_Minute)
   {
     loopMinute = rtc.m_Minute;
-    ReadTemperature(currentTemperature);
-    if (loopMinute == 0 || loopMinute == 30)
+    Minute(sampleTemperature, samplePressure, sampleFresh);
+    if (rtc.m_Minute == 0 || rtc.m_Minute == 30)
     {
-      ReadPressure(currentPressure);
-      adjustedPressure = AdjustedPressure(currentPressure);
-      
-#if defined(CONFIG_MIN_PRESSURE_HPA) && defined(CONFIG_MAX_PRESSURE_HPA)
-      // Map pressure to Zambretti range
-      adjustedPressure = map(adjustedPressure, CONFIG_MIN_PRESSURE_HPA*10, CONFIG_MAX_PRESSURE_HPA*10, ZambrettiMinPressure, ZambrettiMaxPressure);
-#endif  
-      
-      for (int i = 1; i < NUM_READINGS; i++)
-        pressureReadings[i-1] = pressureReadings[i];
-      pressureReadings[NUM_READINGS - 1] = adjustedPressure;
-      tPressure oldPressure = pressureReadings[0];
-      
-      currentForecastLetter = '?';
-      if (oldPressure != kNullPressure)
-      {
-        if ((adjustedPressure - oldPressure) >= +kPressureTrendThreshold)
-        {
-          currentTrendLetter = 'R';
-          currentForecastLetter = LookupForecast(adjustedPressure, pRisingPressureTable, IsSummer()?+1:0);
-        }
-        else if ((adjustedPressure - oldPressure) <= -kPressureTrendThreshold)
-        {
-          currentTrendLetter = 'F';
-          currentForecastLetter = LookupForecast(adjustedPressure, pFallingPressureTable, IsWinter()?-1:0);
-        }
-        else
-        {
-          currentTrendLetter = 'S';
-          currentForecastLetter = LookupForecast(adjustedPressure, pSteadyPressureTable, 0);
-        }
-      }
+      SaveReadings();
+      SaveAggregates();
     }
+    sampleFresh = false;
+    sampleRequested = true;  // for the next minute
   } 
 }
 
+const Aggregate& GetAggregate(bool week, bool pressure)
+{
+  return (week?weekAggregates:dayAggregates)[pressure];
+}
+
 char GetForecast()
 {
   // '?' means N/A
@@ -335,19 +745,22 @@ char GetForecast()
 
 int GetTemperature()
 {
-  return currentTemperature;
+  // rounded to whole degrees, with hysteresis
+  return shownTemperature;
 }
 
-float GetPressure()
+int GetPressure()
 {
-  return currentPressure/10.0;
+  // rounded to whole hPa
+  return (currentPressure + 5)/10;
 }
 
-void GetInfo(int16_t& currentRawP, int16_t& currentAdjP, int16_t& oldAdjP, char& trend)
+void GetInfo(int16_t& currentRawP, int16_t& currentAdjP, int16_t& trendP, uint8_t& confidence, char& trend)
 {
   currentRawP = currentPressure;
   currentAdjP = adjustedPressure;
-  oldAdjP = pressureReadings[0];
+  trendP = TrendPressure();
+  confidence = TrendConfidence();
   trend =  currentTrendLetter;
 }
 
@@ -2,12 +2,27 @@
 
 namespace Weather
 {
+  // Running min/max/mean
+  struct Aggregate
+  {
+    int16_t min;
+    int16_t max;
+    int32_t sum;
+    uint16_t count;   // 0 if none
+    uint8_t minAt;    // when, local time: per day, minutes/10 since midnight. Per week, hours since Monday midnight
+    uint8_t maxAt;
+    int16_t Mean() const;
+  };
+
   // FOR ENTERTAINMENT ONLY!
   void Init();
   void Loop();
+  void Sample();  // service the sensor, from the main loop
+  void Minute(int16_t temperature, int16_t pressure, bool fresh);  // process a minute's sample (0.1C, dPa), called by Loop()
   char GetForecast();
   int GetTemperature();
-  float GetPressure(); // hPa
+  int GetPressure(); // hPa
   const char* GetForecastStr(char letter);
-  void GetInfo(int16_t& currentRawP, int16_t& currentAdjP, int16_t& oldAdjP, char& trend);
+  const Aggregate& GetAggregate(bool week, bool pressure);  // today's or this week's, temperature (0.1C) or MSL pressure (dPa)
+  void GetInfo(int16_t& currentRawP, int16_t& currentAdjP, int16_t& trendP, uint8_t& confidence, char& trend);  // dPa, trend per 3 hours, confidence 0..99%
 };
@@ -0,0 +1 @@
+python encode_moons.py > ..\MoonTable.h
\ No newline at end of file
@@ -0,0 +1,83 @@
+#!/usr/bin/python
+import sys
+import math
+
+# Generate the table of new moons for Moon.cpp, 2000..2099
+# From Jean Meeus, Astronomical Algorithms, 2nd Ed, Chapter 49 (good to seconds), with Delta T from Espenak & Meeus
+# Each new moon is stored as its difference from the mean new moon, n*MEAN_LUNATION_SECONDS after the first (mean) one,
+# in a signed byte, in units of UNIT_SECONDS. So good to +/-UNIT_SECONDS/2 plus a few seconds.
+# The difference is never more than about 15 hours.
+# Times are UTC, seconds since 1/1/2000 00:00
+
+MEAN_LUNATION_SECONDS = 2551443
+UNIT_SECONDS = 480  # 8 minutes
+
+def JDE(k):
+    # Meeus 49.1 etc, the true new moon, Julian Ephemeris Day
+    T = k/1236.85
+    jde = 2451550.09766 + 29.530588861*k + 0.00015437*T**2 - 0.000000150*T**3 + 0.00000000073*T**4
+    E = 1 - 0.002516*T - 0.0000074*T**2
+    rad = math.pi/180
+    M  = (2.5534 + 29.10535670*k - 0.0000014*T**2 - 0.00000011*T**3)*rad
+    Mp = (201.5643 + 385.81693528*k + 0.0107582*T**2 + 0.00001238*T**3 - 0.000000058*T**4)*rad
+    F  = (160.7108 + 390.67050284*k - 0.0016118*T**2 - 0.00000227*T**3 + 0.000000011*T**4)*rad
+    O  = (124.7746 - 1.56375588*k + 0.0020672*T**2 + 0.00000215*T**3)*rad
+    jde += (-0.40720*math.sin(Mp) + 0.17241*E*math.sin(M) + 0.01608*math.sin(2*Mp) + 0.01039*math.sin(2*F) +
+            0.00739*E*math.sin(Mp - M) - 0.00514*E*math.sin(Mp + M) + 0.00208*E*E*math.sin(2*M) - 0.00111*math.sin(Mp - 2*F) -
+            0.00057*math.sin(Mp + 2*F) + 0.00056*E*math.sin(2*Mp + M) - 0.00042*math.sin(3*Mp) + 0.00042*E*math.sin(M + 2*F) +
+            0.00038*E*math.sin(M - 2*F) - 0.00024*E*math.sin(2*Mp - M) - 0.00017*math.sin(O) - 0.00007*math.sin(Mp + 2*M) +
+            0.00004*math.sin(2*Mp - 2*F) + 0.00004*math.sin(3*M) + 0.00003*math.sin(Mp + M - 2*F) + 0.00003*math.sin(2*Mp + 2*F) -
+            0.00003*math.sin(Mp + M + 2*F) + 0.00003*math.sin(Mp - M + 2*F) - 0.00002*math.sin(Mp - M - 2*F) -
+            0.00002*math.sin(3*Mp + M) + 0.00002*math.sin(4*Mp))
+    # planetary arguments
+    A = [299.77 +  0.107408*k - 0.009173*T**2, 251.88 +  0.016321*k, 251.83 + 26.651886*k, 349.42 + 36.412478*k,
+          84.66 + 18.206239*k, 141.74 + 53.303771*k, 207.14 +  2.453732*k, 154.84 +  7.306860*k,
+          34.52 + 27.261239*k, 207.19 +  0.121824*k, 291.34 +  1.844379*k, 161.72 + 24.198154*k,
+         239.56 + 25.513099*k, 331.55 +  3.592518*k]
+    C = [325, 165, 164, 126, 110, 62, 60, 56, 47, 42, 40, 37, 35, 23]
+    jde += sum(c*0.000001*math.sin(a*rad) for a, c in zip(A, C))
+    return jde
+
+def DeltaT(year):
+    # seconds, TT - UT, Espenak & Meeus polynomials
+    if year < 2005:
+        t = year - 2000
+        return 63.86 + 0.3345*t - 0.060374*t**2 + 0.0017275*t**3 + 0.000651814*t**4 + 0.00002373599*t**5
+    if year < 2050:
+        t = year - 2000
+        return 62.92 + 0.32217*t + 0.005589*t**2
+    return -20 + 32*((year - 1820)/100)**2 - 0.5628*(2150 - year)
+
+def Seconds(k):
+    # UTC seconds since 1/1/2000 00:00 (JD 2451544.5)
+    jde = JDE(k)
+    year = 2000 + (jde - 2451544.5)/365.25
+    return (jde - 2451544.5)*86400 - DeltaT(year)
+
+# From the last new moon of 1999 (k = -1), to the first of 2100
+first = int(round((2451550.09766 - 29.530588861 - 2451544.5)*86400 - DeltaT(2000)))  # the mean new moon
+k = -1
+values = []
+while True:
+    diff = Seconds(k) - first - (k + 1)*MEAN_LUNATION_SECONDS
+    value = int(round(diff/UNIT_SECONDS))
+    if value < -128 or value > 127:
+        sys.exit("Out of range at k=" + str(k))
+    values.append(value)
+    if Seconds(k) >= 100*365.25*86400:
+        break
+    k += 1
+
+sys.stdout.write("#pragma once\n")
+sys.stdout.write("// Generated by resources/encode_moons.py, don't edit\n")
+sys.stdout.write("// New moon n is at MOON_FIRST_SECONDS + n*MOON_MEAN_LUNATION_SECONDS + pMoonTable[n]*MOON_UNIT_SECONDS, UTC seconds since 1/1/2000\n")
+sys.stdout.write("#define MOON_FIRST_SECONDS " + str(first) + "L\n")
+sys.stdout.write("#define MOON_MEAN_LUNATION_SECONDS " + str(MEAN_LUNATION_SECONDS) + "UL\n")
+sys.stdout.write("#define MOON_UNIT_SECONDS " + str(UNIT_SECONDS) + "\n")
+sys.stdout.write("#define MOON_TABLE_SIZE " + str(len(values)) + "\n")
+sys.stdout.write("static const int8_t pMoonTable[MOON_TABLE_SIZE] PROGMEM =\n{")
+for idx, value in enumerate(values):
+    if idx % 20 == 0:
+        sys.stdout.write("\n  ")
+    sys.stdout.write(str(value) + ",")
+sys.stdout.write("\n};\n")
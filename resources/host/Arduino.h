@@ -0,0 +1,20 @@
+#pragma once
+// Just enough of Arduino.h to compile the sketch's pure code on a PC, for the tests in resources
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+typedef uint8_t byte;
+typedef uint16_t word;
+
+// No separate program memory
+#define PROGMEM
+#define pgm_read_byte_near(_p) (*(const uint8_t*)(_p))
+#define pgm_read_word_near(_p) (*(const uint16_t*)(_p))
+
+#define min(_a, _b) ((_a) < (_b)?(_a):(_b))
+#define max(_a, _b) ((_a) > (_b)?(_a):(_b))
+#define constrain(_x, _lo, _hi) ((_x) < (_lo)?(_lo):((_x) > (_hi)?(_hi):(_x)))
+
+unsigned long millis();  // the test provides it
@@ -0,0 +1,3 @@
+#pragma once
+// For the tests in resources, no time passes
+#define _delay_us(_us)
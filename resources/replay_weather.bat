@@ -0,0 +1 @@
+g++ -I host -o replay_weather.exe replay_weather.cpp && replay_weather.exe %1
\ No newline at end of file
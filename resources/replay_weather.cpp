@@ -0,0 +1,116 @@
+// Replays a log of readings through Weather.cpp's trend & forecast, on a PC, see replay_weather.bat
+// The log has a line per reading, at the RTC's (standard) time: YYYY-MM-DD HH:MM <temperature C> <pressure hPa>, e.g.
+//   2024-05-01 13:42 18.4 1013.2
+// Readings are in time order, any interval. The device samples every minute, so the minutes between readings are interpolated,
+// up to MAX_GAP_MINUTES apart. Past that they're processed without a fresh sample, as Loop() does when the sensor doesn't answer.
+// Prints the pressure, trend and forecast every half hour, when the forecast is updated
+#include <stdio.h>
+#include "Arduino.h"  // host/
+#define rtc_h         // instead of RTC.h
+class RTC
+{
+  public:
+    bool ReadTime(bool Full) { return true; }
+    bool ReadBytes(byte Index, byte* pData, byte Count) { return false; }
+    bool WriteBytes(byte Index, const byte* pData, byte Count) { return false; }
+    byte m_DayOfMonth, m_Month, m_Year, m_Hour24, m_Minute;
+};
+RTC rtc;
+namespace Config { byte DLS; }
+#define SENSOR_BMP
+namespace BMP280_I2C
+{
+  void Init() {}
+  void StartConversion() {}
+  bool IsReady() { return false; }
+  int16_t GetTemperatureDeciC() { return 0; }
+  int32_t GetPressurePa() { return 0; }
+};
+unsigned long millis() { return 0; }
+#include "../Calendar.cpp"
+#include "../History.cpp"
+#include "../Weather.cpp"
+
+#define MAX_GAP_MINUTES 30
+
+void Replay(unsigned long seconds, int16_t temperature, int16_t pressure, bool fresh)
+{
+  // One minute, at seconds since 1/1/2000
+  int date, month, year, hour, minute;
+  Time::SplitSeconds(seconds, date, month, year, hour, minute);
+  rtc.m_DayOfMonth = date;
+  rtc.m_Month = month;
+  rtc.m_Year = year - 2000;
+  rtc.m_Hour24 = hour;
+  rtc.m_Minute = minute;
+  Weather::Minute(temperature, pressure, fresh);
+  if (minute != 0 && minute != 30)
+    return;
+  int16_t rawP, adjP, trendP;
+  uint8_t confidence;
+  char trend;
+  Weather::GetInfo(rawP, adjP, trendP, confidence, trend);
+  char forecast = Weather::GetForecast();
+  printf("%04d-%02d-%02d %02d:%02d %5.1fC %6.1fhPa MSL %6.1fhPa trend %+5.1fhPa %2d%% %c forecast %c", year, month, date, hour, minute,
+         temperature/10.0, rawP/10.0, adjP/10.0, trendP/10.0, confidence, trend, forecast);
+  const char* pStr = Weather::GetForecastStr(forecast);
+  if (pStr)
+  {
+    printf(" ");
+    for (; *pStr; pStr++)
+      putchar((*pStr == '\n')?' ':*pStr);
+  }
+  printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+  FILE* pLog = (argc > 1)?fopen(argv[1], "r"):stdin;
+  if (!pLog)
+  {
+    printf("Can't open %s\n", argv[1]);
+    return 1;
+  }
+  char line[100];
+  unsigned long minute = 0;  // the next to process
+  int16_t temperature = 0, pressure = 0;
+  int lineNumber = 0;
+  while (fgets(line, sizeof(line), pLog))
+  {
+    lineNumber++;
+    int year, month, date, hour, min;
+    float t, p;
+    if (sscanf(line, "%d-%d-%d %d:%d %f %f", &year, &month, &date, &hour, &min, &t, &p) != 7)
+    {
+      if (line[0] != '\n' && line[0] != '\r' && line[0] != '#')
+        printf("Skipped line %d: %s", lineNumber, line);
+      continue;
+    }
+    unsigned long seconds = Time::MakeSeconds(date, month, year, hour, min);
+    if (minute && seconds < minute)
+    {
+      printf("Line %d is out of order\n", lineNumber);
+      continue;
+    }
+    int16_t nextTemperature = (int16_t)(10*t + ((t < 0)?-0.5f:0.5f));
+    int16_t nextPressure = (int16_t)(10*p + 0.5f);
+    // the minutes since the last reading
+    if (!minute)
+      minute = seconds;
+    long gap = (seconds - minute)/60 + 1;
+    for (long step = 1; minute < seconds; minute += 60, step++)
+    {
+      if (gap > MAX_GAP_MINUTES)
+        Replay(minute, temperature, pressure, false);
+      else
+        Replay(minute, temperature + (nextTemperature - temperature)*step/gap, pressure + (nextPressure - pressure)*step/gap, true);
+    }
+    temperature = nextTemperature;
+    pressure = nextPressure;
+    Replay(seconds, temperature, pressure, true);
+    minute = seconds + 60;
+  }
+  if (pLog != stdin)
+    fclose(pLog);
+  return 0;
+}
@@ -0,0 +1 @@
+g++ -I host -o test_calendar.exe test_calendar.cpp && test_calendar.exe
\ No newline at end of file
@@ -0,0 +1,61 @@
+// Exhaustive test of Calendar.cpp, every day and every minute boundary 2000..2099, on a PC, see test_calendar.bat
+// Against a plain day-by-day count, with the full Gregorian leap year rule (2000 is one, 2100 isn't reached)
+#include <stdio.h>
+#include "Arduino.h"  // host/
+#define rtc_h         // instead of RTC.h
+class RTC
+{
+  public:
+    byte m_DayOfMonth, m_Month, m_Year, m_Hour24, m_Minute;
+};
+RTC rtc;
+#include "../Calendar.cpp"
+
+int bad = 0;
+void Check(bool ok, const char* pWhat, int date, int month, int year)
+{
+  if (!ok && bad++ < 20)
+    printf("%s wrong for %d/%d/%d\n", pWhat, date, month, year);
+}
+
+int main()
+{
+  static const int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  int date = 1, month = 1, year = 2000;
+  int dayOfWeek = 6;  // 1/1/2000 was a Saturday
+  uint16_t day = 0;
+  for (; year < 2100; day++)
+  {
+    bool leap = (year % 4 == 0) && (year % 100 != 0 || year % 400 == 0);
+    int days = daysInMonth[month - 1] + ((month == 2 && leap)?1:0);
+    Check(Time::DaysInMonth(month, year) == days, "DaysInMonth", date, month, year);
+    Check(Time::DayNumber(date, month, year) == day, "DayNumber", date, month, year);
+    int d, m, y, h, mi;
+    Time::FromDayNumber(day, d, m, y);
+    Check(d == date && m == month && y == year, "FromDayNumber", date, month, year);
+    Check(Time::DayOfWeek(day) == dayOfWeek, "DayOfWeek", date, month, year);
+    unsigned long seconds = day*24UL*3600UL;
+    Check(Time::MakeSeconds(date, month, year, 0, 0) == seconds && Time::MakeSeconds(date, month, year, 23, 59) == seconds + 86340UL, "MakeSeconds", date, month, year);
+    Time::SplitSeconds(seconds + 86399UL, d, m, y, h, mi);
+    Check(d == date && m == month && y == year && h == 23 && mi == 59, "SplitSeconds", date, month, year);
+    rtc.m_DayOfMonth = date;
+    rtc.m_Month = month;
+    rtc.m_Year = year - 2000;
+    rtc.m_Hour24 = 12;
+    rtc.m_Minute = 34;
+    Check(Time::RTCSeconds() == seconds + 12*3600UL + 34*60UL, "RTCSeconds", date, month, year);
+    // the next day
+    dayOfWeek = dayOfWeek % 7 + 1;
+    if (++date > days)
+    {
+      date = 1;
+      if (++month > 12)
+      {
+        month = 1;
+        year++;
+      }
+    }
+  }
+  printf("%u days, %d wrong\n", day, bad);
+  return bad?1:0;
+}
@@ -0,0 +1 @@
+g++ -I host -o test_fasti2c.exe test_fasti2c.cpp && test_fasti2c.exe
\ No newline at end of file
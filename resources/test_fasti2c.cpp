@@ -0,0 +1,241 @@
+// Test of FastI2C.cpp on a PC, against a bit-level model of the bus and a slave, see test_fasti2c.bat
+// The port registers are stand-ins: writing DDRB moves the lines (and runs the slave on their edges), reading PINB samples them
+// The slave is a register file, like the DS3231, it can stretch the clock, or hold SCL low for good
+#include <stdio.h>
+#include <string.h>
+#include "Arduino.h"  // host/
+
+#define __AVR_ATmega328P__
+#define B00010000 0x10
+#define B00001000 0x08
+#define BUS_SDA   0x10
+#define BUS_SCL   0x08
+
+// The slave
+enum SlaveMode {SlaveIdle, SlaveAddress, SlaveReceive, SlaveTransmit, SlaveIgnore};
+uint8_t slaveAddress = 0x68;
+uint8_t slaveRegisters[256];
+uint8_t slaveMode = SlaveIdle;
+int8_t slaveBit;         // -1 straight after START
+uint8_t slaveShift;
+uint8_t slavePointer;
+bool slaveGotPointer;
+bool slaveSDALow;        // driving SDA
+bool slaveMasterAck;
+uint16_t stretchReads = 0;  // after each falling edge, hold SCL low for this many reads of PINB
+uint16_t stretchLeft = 0;
+int stickAfterFalls = -1;   // then hold SCL low for good
+bool stuck = false;
+
+uint8_t ddr = 0;
+bool sclLine = true, sdaLine = true;
+
+bool SCLLine() { return !(ddr & BUS_SCL) && !stretchLeft && !stuck; }
+bool SDALine() { return !(ddr & BUS_SDA) && !slaveSDALow; }
+
+void SlaveRise(bool sda)
+{
+  if (slaveMode == SlaveIdle || slaveMode == SlaveIgnore)
+    return;
+  if (slaveBit < 8)
+  {
+    if (slaveMode != SlaveTransmit)
+      slaveShift = (slaveShift << 1) | sda;
+  }
+  else if (slaveMode == SlaveTransmit)
+    slaveMasterAck = !sda;
+}
+
+void SlaveFall()
+{
+  if (stickAfterFalls > 0 && !--stickAfterFalls)
+    stuck = true;
+  if (slaveMode == SlaveIdle || slaveMode == SlaveIgnore)
+    return;
+  stretchLeft = stretchReads;
+  if (++slaveBit == 0)
+    return;  // SCL falling after the START
+  if (slaveBit == 8)
+  {
+    if (slaveMode == SlaveTransmit)
+    {
+      slaveSDALow = false;  // the master ACKs
+      return;
+    }
+    if (slaveMode == SlaveAddress)
+    {
+      if ((slaveShift >> 1) != slaveAddress)
+      {
+        slaveMode = SlaveIgnore;
+        return;
+      }
+      slaveGotPointer = false;
+      slaveMode = (slaveShift & 1)?SlaveTransmit:SlaveReceive;
+    }
+    else if (!slaveGotPointer)
+    {
+      slavePointer = slaveShift;
+      slaveGotPointer = true;
+    }
+    else
+      slaveRegisters[slavePointer++] = slaveShift;
+    slaveSDALow = true;  // ACK
+  }
+  else if (slaveBit == 9)
+  {
+    slaveBit = 0;
+    slaveShift = 0;
+    slaveSDALow = false;
+    if (slaveMode == SlaveTransmit)
+    {
+      if (!slaveMasterAck)
+      {
+        slaveMode = SlaveIgnore;
+        return;
+      }
+      slaveShift = slaveRegisters[slavePointer++];
+      slaveSDALow = !(slaveShift & 0x80);
+    }
+  }
+  else if (slaveMode == SlaveTransmit)
+    slaveSDALow = !(slaveShift & (0x80 >> slaveBit));
+}
+
+void BusUpdate()
+{
+  // Run the slave on the edges since the last update
+  bool scl = SCLLine(), sda = SDALine();
+  if (scl && sclLine && sda != sdaLine)
+  {
+    // START or STOP
+    slaveMode = sda?SlaveIdle:SlaveAddress;
+    slaveBit = -1;
+    slaveShift = 0;
+    slaveSDALow = false;
+  }
+  else if (scl && !sclLine)
+    SlaveRise(sda);
+  else if (!scl && sclLine)
+    SlaveFall();
+  sclLine = scl;
+  sdaLine = SDALine();
+}
+
+struct DDRRegister
+{
+  void operator|=(uint8_t bits) { ddr |= bits; BusUpdate(); }
+  void operator&=(uint8_t bits) { ddr &= bits; BusUpdate(); }
+};
+DDRRegister DDRB;
+
+uint8_t BusPins()
+{
+  if (stretchLeft && !--stretchLeft)
+    BusUpdate();
+  return (SCLLine()?BUS_SCL:0) | (SDALine()?BUS_SDA:0);
+}
+#define PINB BusPins()
+
+// The rest of the ATmega328P that FastI2C.cpp uses
+uint8_t PORTB, SREG, TCCR2A, TCCR2B, TCNT2, OCR2A, TIFR2, TIMSK2;
+#define WGM21 1
+#define CS21  1
+#define OCF2A 1
+#define OCIE2A 1
+#define cli()
+#define ISR(_vector) void _vector()
+
+#include "../FastI2C.cpp"
+
+FastI2C bus;
+int failures = 0;
+void Check(bool ok, const char* pWhat)
+{
+  printf("%s %s\n", ok?"ok  ":"FAIL", pWhat);
+  failures += !ok;
+}
+
+void Reset()
+{
+  // A fresh, idle bus
+  stretchReads = stretchLeft = 0;
+  stickAfterFalls = -1;
+  stuck = false;
+  slaveMode = SlaveIdle;
+  slaveMode = SlaveIdle;
+  slaveSDALow = false;
+  ddr = 0;
+  sclLine = sdaLine = true;
+  bus.begin();
+}
+
+bool RunAsync()
+{
+  // Run the interrupt until it's done with the queue, false if it never is
+  for (long ticks = 0; ticks < 100000L; ticks++)
+  {
+    if (!(TIMSK2 & (1 << OCIE2A)))
+      return true;
+    TIMER2_COMPA_vect();
+    BusPins();  // time passes for a stretching slave
+  }
+  return false;
+}
+
+int main()
+{
+  for (int r = 0; r < 256; r++)
+    slaveRegisters[r] = r ^ 0x5A;
+  uint8_t data[7];
+
+  Reset();
+  Check(bus.ReadRegisters(0x68, 0x00, data, 7) && !memcmp(data, "\x5A\x5B\x58\x59\x5E\x5F\x5C", 7), "ReadRegisters");
+  const uint8_t written[] = {0x12, 0x34, 0x56};
+  Check(bus.WriteRegisters(0x68, 0x14, written, 3) && !memcmp(slaveRegisters + 0x14, written, 3), "WriteRegisters");
+  Check(!bus.ReadRegisters(0x57, 0x00, data, 1), "ReadRegisters, no such slave, NACKed");
+  Check(bus.beginTransmission(0x68) && bus.write(0x01) && !bus.endTransmission(), "Wire-like write");
+  Check(bus.requestFrom(0x68, 2) == 2 && bus.read() == (0x01 ^ 0x5A) && bus.read() == (0x02 ^ 0x5A) && bus.read() == 0xFF, "Wire-like read");
+
+  Reset();
+  stretchReads = 50;
+  Check(bus.ReadRegisters(0x68, 0x10, data, 2) && data[0] == (0x10 ^ 0x5A) && data[1] == (0x11 ^ 0x5A), "stretched clock, within the limit");
+
+  Reset();
+  stuck = true;
+  Check(!bus.ReadRegisters(0x68, 0x00, data, 7), "SCL held low, START fails");
+
+  Reset();
+  stickAfterFalls = 9*4 + 3;  // part way through the first byte read back
+  memset(data, 0, sizeof(data));
+  Check(!bus.ReadRegisters(0x68, 0x00, data, 7), "SCL held low while reading, fails");
+
+  Reset();
+  stickAfterFalls = 9*2 + 5;  // part way through a byte written
+  Check(!bus.WriteRegisters(0x68, 0x20, written, 3), "SCL held low while writing, fails");
+
+  Reset();
+  I2CTransaction read = {0x68, 0x03, data, 4, true, I2C_IDLE};
+  uint8_t writeData[2] = {0xA5, 0xC3};
+  I2CTransaction write = {0x68, 0x30, writeData, 2, false, I2C_IDLE};
+  memset(data, 0, sizeof(data));
+  Check(bus.Queue(&read) && bus.Queue(&write) && RunAsync() && read.status == I2C_DONE && write.status == I2C_DONE &&
+        data[0] == (0x03 ^ 0x5A) && data[3] == (0x06 ^ 0x5A) && slaveRegisters[0x30] == 0xA5 && slaveRegisters[0x31] == 0xC3, "queued read & write");
+
+  Reset();
+  stretchReads = 10;
+  read.status = I2C_IDLE;
+  Check(bus.Queue(&read) && RunAsync() && read.status == I2C_DONE && data[1] == (0x04 ^ 0x5A), "queued, stretched clock, within the limit");
+
+  Reset();
+  stickAfterFalls = 9*3 + 4;
+  read.status = write.status = I2C_IDLE;
+  Check(bus.Queue(&read) && bus.Queue(&write) && RunAsync() && read.status == I2C_FAILED && write.status == I2C_FAILED && !bus.Busy(),
+        "queued, SCL held low, both fail and the queue empties");
+  stuck = false;  // the slave recovers
+  slaveMode = SlaveIdle;
+  slaveSDALow = false;
+  Check(bus.ReadRegisters(0x68, 0x00, data, 1) && data[0] == 0x5A, "then a synchronous read, once SCL's free");
+
+  printf("%d failed\n", failures);
+  return failures?1:0;
+}
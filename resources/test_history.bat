@@ -0,0 +1 @@
+g++ -I host -o test_history.exe test_history.cpp && test_history.exe
\ No newline at end of file
@@ -0,0 +1,84 @@
+// Soak test of History.cpp, on a PC, see test_history.bat
+// Random samples, some missing, against a plain array of everything added. The iterator must return the newest Count() exactly
+#include <stdio.h>
+#include "Arduino.h"  // host/
+#define CONFIG_HISTORY
+#include "../History.cpp"
+using namespace History;
+
+int failures = 0;
+void Check(bool ok, const char* pWhat)
+{
+  printf("%s %s\n", ok?"ok  ":"FAIL", pWhat);
+  failures += !ok;
+}
+
+bool Matches(const int16_t* pTemperatures, const int16_t* pPressures, uint32_t firstInterval, uint32_t added)
+{
+  // The iterator's samples are the newest Count() of those added, oldest first
+  uint32_t idx = added - Count();
+  Iterator iterator;
+  int16_t temperature, pressure;
+  while (iterator.Next(temperature, pressure))
+  {
+    if (temperature != pTemperatures[idx] || pressure != pPressures[idx] || iterator.Interval() != firstInterval + idx)
+      return false;
+    idx++;
+  }
+  return idx == added;
+}
+
+int main()
+{
+  static int16_t temperatures[20000], pressures[20000];
+  const uint32_t kFirst = 1000;
+  Clear();
+  srand(1);
+  bool ok = true;
+  uint16_t least = 0xFFFF;
+  int16_t temperature = 200, pressure = 10100;
+  for (uint32_t n = 0; n < 20000; n++)
+  {
+    // changes well inside the clamp, so the samples are exact
+    temperature += rand() % 21 - 10;
+    pressure += rand() % 11 - 5;
+    temperatures[n] = (rand() % 5 == 0)?kMissing:temperature;
+    pressures[n] = (rand() % 7 == 0)?kMissing:pressure;
+    Add(kFirst + n, temperatures[n], pressures[n]);
+    if (n % 97 == 0)
+    {
+      ok = ok && Matches(temperatures, pressures, kFirst, n + 1);
+      if (n > HISTORY_BLOCKS*HISTORY_BLOCK_SAMPLES && Count() < least)
+        least = Count();
+    }
+  }
+  Check(ok, "20000 random samples");
+  Check(least >= 40*60/HISTORY_INTERVAL_MINUTES, "at least 40 hours kept");
+
+  Clear();
+  Add(50, 200, 10100);
+  Add(53, 210, 10110);
+  temperatures[0] = 200; temperatures[1] = temperatures[2] = kMissing; temperatures[3] = 210;
+  pressures[0] = 10100;  pressures[1] = pressures[2] = kMissing;       pressures[3] = 10110;
+  Check(Count() == 4 && NewestInterval() == 53 && Matches(temperatures, pressures, 50, 4), "skipped intervals are missing");
+
+  Add(53, 300, 10300);
+  Check(Count() == 4 && Matches(temperatures, pressures, 50, 4), "the same interval again is ignored");
+
+  Add(49, 220, 10120);
+  temperatures[0] = 220;
+  pressures[0] = 10120;
+  Check(Count() == 1 && Matches(temperatures, pressures, 49, 1), "an earlier interval clears the history");
+
+  Clear();
+  Add(10, 200, 10100);
+  Add(11, 500, 10100);
+  Add(12, 500, 10100);
+  Add(13, 500, 10100);
+  temperatures[0] = 200; temperatures[1] = 327; temperatures[2] = 454; temperatures[3] = 500;
+  pressures[0] = pressures[1] = pressures[2] = pressures[3] = 10100;
+  Check(Matches(temperatures, pressures, 10, 4), "a big change is clamped, then catches up");
+
+  printf("%d failed\n", failures);
+  return failures?1:0;
+}
@@ -0,0 +1 @@
+g++ -I host -o test_zambretti.exe test_zambretti.cpp && test_zambretti.exe
\ No newline at end of file
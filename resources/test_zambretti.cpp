@@ -0,0 +1,81 @@
+// Test of Weather.cpp's forecast indexes, on a PC, see test_zambretti.bat
+// Every pressure, trend and month, the index lookup against the nearest-neighbour search of the tables it replaced
+#include <stdio.h>
+#include "Arduino.h"  // host/
+#define rtc_h         // instead of RTC.h
+class RTC
+{
+  public:
+    bool ReadTime(bool Full) { return true; }
+    bool ReadBytes(byte Index, byte* pData, byte Count) { return false; }
+    bool WriteBytes(byte Index, const byte* pData, byte Count) { return false; }
+    byte m_DayOfMonth, m_Month, m_Year, m_Hour24, m_Minute;
+};
+RTC rtc;
+namespace Config { byte DLS; }
+#define SENSOR_BMP
+namespace BMP280_I2C
+{
+  void Init() {}
+  void StartConversion() {}
+  bool IsReady() { return false; }
+  int16_t GetTemperatureDeciC() { return 0; }
+  int32_t GetPressurePa() { return 0; }
+};
+unsigned long millis() { return 0; }
+#include "../Calendar.cpp"
+#include "../History.cpp"
+#include "../Weather.cpp"
+using namespace Weather;
+
+char SearchTable(tPressure currentPressureMSL, const char* pTable, int8_t seasonAdjustment)
+{
+  // Weather.cpp's LookupForecast before the indexes, the letter for the table pressure closest to currentPressure
+  const char* pLetters = pTable;
+  const char* pPressures = pTable + strlen(pTable) + 1;
+  tPressure tablePressure = 10*(*pPressures++ + PRESSURE_OFFSET);
+  if (currentPressureMSL > tablePressure)
+    return ' '; // outside range
+  const char* pClosestLetter = pLetters++;
+  tPressure minDiff = abs(currentPressureMSL - tablePressure);
+  while (*pLetters)
+  {
+    tablePressure = 10*(*pPressures + PRESSURE_OFFSET);
+    tPressure diff = abs(currentPressureMSL - tablePressure);
+    if (diff < minDiff)
+    {
+      minDiff = diff;
+      pClosestLetter = pLetters;
+    }
+    pLetters++;
+    pPressures++;
+  }
+  if (currentPressureMSL < tablePressure)
+    return ' ';  // outside range
+  if (seasonAdjustment == +1 && pClosestLetter[1])
+    pClosestLetter++;
+  else if (seasonAdjustment == -1 && pClosestLetter != pTable)
+    pClosestLetter--;
+  return *pClosestLetter;
+}
+
+int main()
+{
+  int bad = 0, count = 0;
+  for (rtc.m_Month = 1; rtc.m_Month <= 12; rtc.m_Month++)
+    for (tPressure pressure = 9000; pressure <= 11000; pressure++)
+    {
+      char expected[] = {SearchTable(pressure, pRisingPressureTable, IsSummer()?+1:0),
+                         SearchTable(pressure, pFallingPressureTable, IsWinter()?-1:0),
+                         SearchTable(pressure, pSteadyPressureTable, 0)};
+      const char* pTrends = "RFS";
+      for (int trend = 0; trend < 3; trend++, count++)
+      {
+        char letter = TrendForecast(pTrends[trend], pressure);
+        if (letter != expected[trend] && bad++ < 20)
+          printf("%c at %d.%d hPa in month %d is '%c', should be '%c'\n", pTrends[trend], pressure/10, pressure % 10, rtc.m_Month, letter, expected[trend]);
+      }
+    }
+  printf("%d forecasts, %d wrong\n", count, bad);
+  return bad?1:0;
+}